@@ -37,10 +37,10 @@ int main(int argc, char* const argv[]) {
 #else
     JitInit(L"libclrjit.so");
 #endif
-    g_pyjionSettings.graph = true;
-    g_pyjionSettings.debug = true;
-    g_pyjionSettings.codeObjectSizeLimit = 1000000;
-    g_pyjionSettings.exceptionHandling = true;
+    PyJit_Settings().graph = true;
+    PyJit_Settings().debug = true;
+    PyJit_Settings().codeObjectSizeLimit = 1000000;
+    PyJit_Settings().exceptionHandling = true;
     setOptimizationLevel(2);
     int result = Catch::Session().run(argc, argv);
     Py_Finalize();
@@ -0,0 +1,244 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) Microsoft Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+/**
+ Compile throughput benchmark.
+
+ Walks every code object (recursively through co_consts) of the Python modules found under a directory,
+ the installed standard library by default, and compiles each one with AbstractInterpreter::compile.
+
+ Usage: compile_bench [directory] [max modules] [optimization level]
+*/
+
+#include <Python.h>
+#include <pyjit.h>
+#include <pycomp.h>
+#include <absint.h>
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef WINDOWS
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std::chrono;
+
+static double g_clrjitTime = 0;
+
+/* Wraps the code generator to attribute the time spent inside clrjit's compileMethod */
+class TimedPythonCompiler : public PythonCompiler {
+public:
+    explicit TimedPythonCompiler(PyCodeObject* code) : PythonCompiler(code) {}
+
+    JittedCode* emit_compile() override {
+        auto start = steady_clock::now();
+        auto res = PythonCompiler::emit_compile();
+        g_clrjitTime += duration<double>(steady_clock::now() - start).count();
+        return res;
+    }
+};
+
+static const char* compileResultName(AbstractInterpreterResult result) {
+    switch (result) {
+        case NoResult:
+            return "NoResult";
+        case Success:
+            return "Success";
+        case CompilationException:
+            return "CompilationException";
+        case CompilationJitFailure:
+            return "CompilationJitFailure";
+        case CompilationStackEffectFault:
+            return "CompilationStackEffectFault";
+        case IncompatibleCompilerFlags:
+            return "IncompatibleCompilerFlags";
+        case IncompatibleSize:
+            return "IncompatibleSize";
+        case IncompatibleOpcode_Yield:
+            return "IncompatibleOpcode_Yield";
+        case IncompatibleOpcode_WithExcept:
+            return "IncompatibleOpcode_WithExcept";
+        case IncompatibleOpcode_With:
+            return "IncompatibleOpcode_With";
+        case IncompatibleOpcode_Unknown:
+            return "IncompatibleOpcode_Unknown";
+        case IncompatibleFrameGlobal:
+            return "IncompatibleFrameGlobal";
+        default:
+            return "Unknown";
+    }
+}
+
+static size_t peakMemory() {
+#ifdef WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+/* Returns a list of module code objects, compiled from the .py files under root. */
+static PyObject* collectModules(const char* root, long limit) {
+    const char* collector = "import os, sysconfig\n"
+                            "def collect(root, limit):\n"
+                            "    root = root or sysconfig.get_paths()['stdlib']\n"
+                            "    result = []\n"
+                            "    for path, dirs, files in os.walk(root):\n"
+                            "        dirs[:] = sorted(d for d in dirs if d not in ('site-packages', 'test', 'tests'))\n"
+                            "        for name in sorted(files):\n"
+                            "            if not name.endswith('.py'):\n"
+                            "                continue\n"
+                            "            if limit and len(result) >= limit:\n"
+                            "                return result\n"
+                            "            filename = os.path.join(path, name)\n"
+                            "            try:\n"
+                            "                with open(filename, 'rb') as f:\n"
+                            "                    result.append(compile(f.read(), filename, 'exec'))\n"
+                            "            except (SyntaxError, ValueError, UnicodeDecodeError, OSError):\n"
+                            "                pass\n"
+                            "    return result\n";
+    auto globals = PyObject_ptr(PyDict_New());
+    PyDict_SetItemString(globals.get(), "__builtins__", PyEval_GetBuiltins());
+    auto res = PyObject_ptr(PyRun_String(collector, Py_file_input, globals.get(), globals.get()));
+    if (res.get() == nullptr)
+        return nullptr;
+    auto collect = PyDict_GetItemString(globals.get(), "collect");
+    auto rootArg = root != nullptr ? PyUnicode_FromString(root) : Py_NewRef(Py_None);
+    auto modules = PyObject_CallFunction(collect, "Nl", rootArg, limit);
+    return modules;
+}
+
+static void walkCode(PyCodeObject* code, std::vector<PyCodeObject*>& result) {
+    result.push_back(code);
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(code->co_consts); i++) {
+        auto constValue = PyTuple_GET_ITEM(code->co_consts, i);
+        if (PyCode_Check(constValue))
+            walkCode((PyCodeObject*) constValue, result);
+    }
+}
+
+int main(int argc, char* const argv[]) {
+    Py_Initialize();
+    PyjionUnboxingError = PyErr_NewException("pyjion.PyjionUnboxingError", PyExc_ValueError, nullptr);
+#ifdef WINDOWS
+    JitInit(L"clrjit.dll");
+#else
+    JitInit(L"libclrjit.so");
+#endif
+    setOptimizationLevel(argc > 3 ? atoi(argv[3]) : 1);
+
+    const char* root = argc > 1 ? argv[1] : nullptr;
+    long limit = argc > 2 ? atol(argv[2]) : 0;
+
+    auto modules = PyObject_ptr(collectModules(root, limit));
+    if (modules.get() == nullptr) {
+        PyErr_Print();
+        return 1;
+    }
+
+    std::vector<PyCodeObject*> codeObjects;
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(modules.get()); i++) {
+        walkCode((PyCodeObject*) PyList_GET_ITEM(modules.get(), i), codeObjects);
+    }
+
+    auto globals = PyObject_ptr(PyDict_New());
+    auto builtins = PyEval_GetBuiltins();
+    PyDict_SetItemString(globals.get(), "__builtins__", builtins);
+
+    std::map<std::string, size_t> results;
+    size_t compiled = 0, ilBytes = 0, nativeBytes = 0;
+    double analysisTime = 0, totalTime = 0;
+
+    for (auto code : codeObjects) {
+        // Abstract interpretation and the instruction graph, measured on their own so they can be separated from IL emission.
+        auto start = steady_clock::now();
+        {
+            AbstractInterpreter analysis(code, nullptr);
+            PyjionCodeProfile profile;
+            if (analysis.interpret(builtins, globals.get(), &profile, Uncompiled) == Success) {
+                bool unboxVars = OPT_ENABLED(Unboxing) && !(code->co_flags & CO_GENERATOR);
+                delete analysis.buildInstructionGraph(unboxVars);
+            }
+        }
+        analysisTime += duration<double>(steady_clock::now() - start).count();
+
+        start = steady_clock::now();
+        TimedPythonCompiler jitter(code);
+        AbstractInterpreter interp(code, &jitter);
+        PyjionCodeProfile profile;
+        auto res = interp.compile(builtins, globals.get(), &profile, Uncompiled);
+        totalTime += duration<double>(steady_clock::now() - start).count();
+
+        results[compileResultName(res.result)]++;
+        if (res.compiledCode != nullptr && res.result == Success) {
+            compiled++;
+            ilBytes += res.compiledCode->get_il_len();
+            nativeBytes += res.compiledCode->get_native_size();
+        }
+        delete res.compiledCode;
+        Py_XDECREF(res.instructionGraph);
+        PyErr_Clear();
+    }
+
+    double emitTime = totalTime - analysisTime - g_clrjitTime;
+    if (emitTime < 0)
+        emitTime = 0;
+
+    printf("Modules:             %zd\n", PyList_GET_SIZE(modules.get()));
+    printf("Code objects:        %zu\n", codeObjects.size());
+    printf("Compiled:            %zu\n", compiled);
+    printf("Total compile time:  %.3fs\n", totalTime);
+    printf("Functions/sec:       %.1f\n", totalTime > 0 ? codeObjects.size() / totalTime : 0.0);
+    printf("  Interpret + graph: %.3fs\n", analysisTime);
+    printf("  IL emission:       %.3fs\n", emitTime);
+    printf("  CLR JIT:           %.3fs\n", g_clrjitTime);
+    printf("IL bytes:            %zu\n", ilBytes);
+    printf("Native bytes:        %zu\n", nativeBytes);
+    printf("Peak memory:         %.1fMiB\n", peakMemory() / (1024.0 * 1024.0));
+    printf("Results:\n");
+    for (auto& result : results) {
+        printf("  %-28s %zu\n", result.first.c_str(), result.second);
+    }
+
+    modules.reset(nullptr);
+    Py_Finalize();
+    return 0;
+}
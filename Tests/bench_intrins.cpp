@@ -0,0 +1,384 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) Microsoft Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+/**
+ Microbenchmarks for the runtime helpers in intrins.cpp.
+
+ Each intrinsic is timed against the CPython C-API path the interpreter loop would take for the same opcode.
+ The intrinsics consume (decref) their arguments, so each iteration increfs them first; the C-API side does
+ the same increfs/decrefs so both sides do equivalent reference counting work.
+
+ Usage: intrins_bench [iterations] [filter]
+*/
+
+#include <Python.h>
+#include <pyjit.h>
+#include <intrins.h>
+#include <util.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+using namespace std::chrono;
+
+static size_t g_iterations = 1000000;
+static const char* g_filter = nullptr;
+static const size_t g_samples = 5;
+
+/* Returns the median time per call, in nanoseconds. */
+static double timeit(const std::function<void()>& body) {
+    std::vector<double> samples;
+    for (size_t s = 0; s < g_samples; s++) {
+        auto start = steady_clock::now();
+        for (size_t i = 0; i < g_iterations; i++) {
+            body();
+        }
+        samples.push_back(duration<double, std::nano>(steady_clock::now() - start).count() / g_iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[g_samples / 2];
+}
+
+static void compare(const char* name, const std::function<void()>& intrinsic, const std::function<void()>& capi) {
+    if (g_filter != nullptr && strstr(name, g_filter) == nullptr)
+        return;
+    // warm up caches and any lazily initialised state
+    intrinsic();
+    capi();
+    if (PyErr_Occurred()) {
+        printf("%-28s raised an exception\n", name);
+        PyErr_Print();
+        return;
+    }
+    auto intrinsicTime = timeit(intrinsic);
+    auto capiTime = timeit(capi);
+    printf("%-28s %10.2fns %10.2fns %+8.1f%%\n", name, intrinsicTime, capiTime, (intrinsicTime - capiTime) / capiTime * 100.0);
+}
+
+static PyObject* evalExpression(const char* expr, PyObject* globals) {
+    auto res = PyRun_String(expr, Py_eval_input, globals, globals);
+    if (res == nullptr)
+        PyErr_Print();
+    return res;
+}
+
+static void runBenchmarks() {
+    auto globals = PyObject_ptr(PyDict_New());
+    PyDict_SetItemString(globals.get(), "__builtins__", PyEval_GetBuiltins());
+    PyRun_String("import itertools\n"
+                 "class C:\n"
+                 "    def __init__(self):\n"
+                 "        self.x = 1\n"
+                 "def f0(): return None\n"
+                 "def f1(a): return a\n"
+                 "def f2(a, b): return a\n"
+                 "def f3(a, b, c): return a\n"
+                 "def f10(a, b, c, d, e, f, g, h, i, j): return a\n",
+                 Py_file_input, globals.get(), globals.get());
+
+    auto list = PyObject_ptr(evalExpression("list(range(100))", globals.get()));
+    auto tuple = PyObject_ptr(evalExpression("tuple(range(100))", globals.get()));
+    auto dict = PyObject_ptr(evalExpression("{str(i): i for i in range(100)}", globals.get()));
+    auto instance = PyObject_ptr(evalExpression("C()", globals.get()));
+    auto repeater = PyObject_ptr(evalExpression("itertools.repeat(1)", globals.get()));
+    auto listIter = PyObject_ptr(evalExpression("itertools.cycle(range(100))", globals.get()));
+    auto f0 = PyDict_GetItemString(globals.get(), "f0");
+    auto f1 = PyDict_GetItemString(globals.get(), "f1");
+    auto f2 = PyDict_GetItemString(globals.get(), "f2");
+    auto f3 = PyDict_GetItemString(globals.get(), "f3");
+    auto f10 = PyDict_GetItemString(globals.get(), "f10");
+    auto builtinLen = PyDict_GetItemString(PyEval_GetBuiltins(), "len");
+    auto index = PyObject_ptr(PyLong_FromLong(50));
+    auto left = PyObject_ptr(PyLong_FromLong(1000));
+    auto right = PyObject_ptr(PyLong_FromLong(2000));
+    auto fleft = PyObject_ptr(PyFloat_FromDouble(1000.0));
+    auto fright = PyObject_ptr(PyFloat_FromDouble(2000.0));
+    auto key = PyObject_ptr(PyUnicode_InternFromString("50"));
+    auto attr = PyObject_ptr(PyUnicode_InternFromString("x"));
+    auto keyHash = PyObject_Hash(key.get());
+    PyTraceInfo traceInfo = {};
+    PyObject* args[10];
+    for (auto& arg : args)
+        arg = index.get();
+
+    printf("%-28s %12s %12s %9s\n", "Intrinsic", "Pyjion", "CPython", "Delta");
+
+    compare(
+            "PyJit_SubscrListIndex",
+            [&] {
+                Py_INCREF(list.get());
+                Py_INCREF(index.get());
+                Py_DECREF(PyJit_SubscrListIndex(list.get(), index.get(), 50));
+            },
+            [&] {
+                Py_INCREF(list.get());
+                Py_INCREF(index.get());
+                Py_DECREF(PyObject_GetItem(list.get(), index.get()));
+                Py_DECREF(list.get());
+                Py_DECREF(index.get());
+            });
+    compare(
+            "PyJit_SubscrList",
+            [&] {
+                Py_INCREF(list.get());
+                Py_INCREF(index.get());
+                Py_DECREF(PyJit_SubscrList(list.get(), index.get()));
+            },
+            [&] {
+                Py_INCREF(list.get());
+                Py_INCREF(index.get());
+                Py_DECREF(PyObject_GetItem(list.get(), index.get()));
+                Py_DECREF(list.get());
+                Py_DECREF(index.get());
+            });
+    compare(
+            "PyJit_SubscrTupleIndex",
+            [&] {
+                Py_INCREF(tuple.get());
+                Py_INCREF(index.get());
+                Py_DECREF(PyJit_SubscrTupleIndex(tuple.get(), index.get(), 50));
+            },
+            [&] {
+                Py_INCREF(tuple.get());
+                Py_INCREF(index.get());
+                Py_DECREF(PyObject_GetItem(tuple.get(), index.get()));
+                Py_DECREF(tuple.get());
+                Py_DECREF(index.get());
+            });
+    compare(
+            "PyJit_SubscrDictHash",
+            [&] {
+                Py_INCREF(dict.get());
+                Py_INCREF(key.get());
+                Py_DECREF(PyJit_SubscrDictHash(dict.get(), key.get(), keyHash));
+            },
+            [&] {
+                Py_INCREF(dict.get());
+                Py_INCREF(key.get());
+                Py_DECREF(PyObject_GetItem(dict.get(), key.get()));
+                Py_DECREF(dict.get());
+                Py_DECREF(key.get());
+            });
+    compare(
+            "PyJit_StoreSubscrListIndex",
+            [&] {
+                Py_INCREF(index.get());
+                Py_INCREF(list.get());
+                Py_INCREF(index.get());
+                PyJit_StoreSubscrListIndex(index.get(), list.get(), index.get(), 50);
+            },
+            [&] {
+                Py_INCREF(index.get());
+                Py_INCREF(list.get());
+                Py_INCREF(index.get());
+                PyObject_SetItem(list.get(), index.get(), index.get());
+                Py_DECREF(index.get());
+                Py_DECREF(list.get());
+                Py_DECREF(index.get());
+            });
+    compare(
+            "PyJit_RichCompare (int)",
+            [&] {
+                Py_INCREF(left.get());
+                Py_INCREF(right.get());
+                Py_DECREF(PyJit_RichCompare(left.get(), right.get(), Py_LT));
+            },
+            [&] {
+                Py_INCREF(left.get());
+                Py_INCREF(right.get());
+                Py_DECREF(PyObject_RichCompare(left.get(), right.get(), Py_LT));
+                Py_DECREF(left.get());
+                Py_DECREF(right.get());
+            });
+    compare(
+            "PyJit_RichCompare (float)",
+            [&] {
+                Py_INCREF(fleft.get());
+                Py_INCREF(fright.get());
+                Py_DECREF(PyJit_RichCompare(fleft.get(), fright.get(), Py_LT));
+            },
+            [&] {
+                Py_INCREF(fleft.get());
+                Py_INCREF(fright.get());
+                Py_DECREF(PyObject_RichCompare(fleft.get(), fright.get(), Py_LT));
+                Py_DECREF(fleft.get());
+                Py_DECREF(fright.get());
+            });
+    compare(
+            "PyJit_Add (int)",
+            [&] {
+                Py_INCREF(left.get());
+                Py_INCREF(right.get());
+                Py_DECREF(PyJit_Add(left.get(), right.get()));
+            },
+            [&] {
+                Py_INCREF(left.get());
+                Py_INCREF(right.get());
+                Py_DECREF(PyNumber_Add(left.get(), right.get()));
+                Py_DECREF(left.get());
+                Py_DECREF(right.get());
+            });
+    compare(
+            "PyJit_LoadAttr",
+            [&] {
+                Py_INCREF(instance.get());
+                Py_DECREF(PyJit_LoadAttr(instance.get(), attr.get()));
+            },
+            [&] {
+                Py_INCREF(instance.get());
+                Py_DECREF(PyObject_GetAttr(instance.get(), attr.get()));
+                Py_DECREF(instance.get());
+            });
+    compare(
+            "PyJit_IterNext (repeat)",
+            [&] {
+                Py_DECREF(PyJit_IterNext(repeater.get()));
+            },
+            [&] {
+                Py_DECREF(PyIter_Next(repeater.get()));
+            });
+    compare(
+            "PyJit_IterNext (cycle)",
+            [&] {
+                Py_DECREF(PyJit_IterNext(listIter.get()));
+            },
+            [&] {
+                Py_DECREF(PyIter_Next(listIter.get()));
+            });
+    compare(
+            "Call0",
+            [&] {
+                Py_INCREF(f0);
+                Py_DECREF(Call0(f0, &traceInfo));
+            },
+            [&] {
+                Py_INCREF(f0);
+                Py_DECREF(PyObject_Vectorcall(f0, nullptr, 0, nullptr));
+                Py_DECREF(f0);
+            });
+    compare(
+            "Call1",
+            [&] {
+                Py_INCREF(f1);
+                Py_INCREF(args[0]);
+                Py_DECREF(Call1(f1, args[0], &traceInfo));
+            },
+            [&] {
+                Py_INCREF(f1);
+                Py_INCREF(args[0]);
+                Py_DECREF(PyObject_Vectorcall(f1, args, 1, nullptr));
+                Py_DECREF(f1);
+                Py_DECREF(args[0]);
+            });
+    compare(
+            "Call1 (builtin)",
+            [&] {
+                Py_INCREF(builtinLen);
+                Py_INCREF(list.get());
+                Py_DECREF(Call1(builtinLen, list.get(), &traceInfo));
+            },
+            [&] {
+                PyObject* lenArgs[1] = {list.get()};
+                Py_INCREF(builtinLen);
+                Py_INCREF(list.get());
+                Py_DECREF(PyObject_Vectorcall(builtinLen, lenArgs, 1, nullptr));
+                Py_DECREF(builtinLen);
+                Py_DECREF(list.get());
+            });
+    compare(
+            "Call2",
+            [&] {
+                Py_INCREF(f2);
+                for (size_t i = 0; i < 2; i++)
+                    Py_INCREF(args[i]);
+                Py_DECREF(Call2(f2, args[0], args[1], &traceInfo));
+            },
+            [&] {
+                Py_INCREF(f2);
+                for (size_t i = 0; i < 2; i++)
+                    Py_INCREF(args[i]);
+                Py_DECREF(PyObject_Vectorcall(f2, args, 2, nullptr));
+                Py_DECREF(f2);
+                for (size_t i = 0; i < 2; i++)
+                    Py_DECREF(args[i]);
+            });
+    compare(
+            "Call3",
+            [&] {
+                Py_INCREF(f3);
+                for (size_t i = 0; i < 3; i++)
+                    Py_INCREF(args[i]);
+                Py_DECREF(Call3(f3, args[0], args[1], args[2], &traceInfo));
+            },
+            [&] {
+                Py_INCREF(f3);
+                for (size_t i = 0; i < 3; i++)
+                    Py_INCREF(args[i]);
+                Py_DECREF(PyObject_Vectorcall(f3, args, 3, nullptr));
+                Py_DECREF(f3);
+                for (size_t i = 0; i < 3; i++)
+                    Py_DECREF(args[i]);
+            });
+    compare(
+            "Call10",
+            [&] {
+                Py_INCREF(f10);
+                for (auto& arg : args)
+                    Py_INCREF(arg);
+                Py_DECREF(Call10(f10, args[0], args[1], args[2], args[3], args[4], args[5], args[6], args[7], args[8], args[9], &traceInfo));
+            },
+            [&] {
+                Py_INCREF(f10);
+                for (auto& arg : args)
+                    Py_INCREF(arg);
+                Py_DECREF(PyObject_Vectorcall(f10, args, 10, nullptr));
+                Py_DECREF(f10);
+                for (auto& arg : args)
+                    Py_DECREF(arg);
+            });
+}
+
+int main(int argc, char* const argv[]) {
+    Py_Initialize();
+    PyjionUnboxingError = PyErr_NewException("pyjion.PyjionUnboxingError", PyExc_ValueError, nullptr);
+#ifdef WINDOWS
+    JitInit(L"clrjit.dll");
+#else
+    JitInit(L"libclrjit.so");
+#endif
+    if (argc > 1)
+        g_iterations = strtoul(argv[1], nullptr, 10);
+    if (argc > 2)
+        g_filter = argv[2];
+
+    runBenchmarks();
+
+    Py_Finalize();
+    return 0;
+}
@@ -0,0 +1,203 @@
+"""Test the performance of a WSGI application under a server-like workload.
+
+The application does routing, HTML templating and JSON serialization and is driven by an in-process fake
+WSGI server, so no sockets are involved. Run directly to see requests/sec and p50/p99 latency per window of
+requests over time, which shows the JIT warm-up curve.
+"""
+import argparse
+import json
+import re
+import time
+from html import escape
+from io import BytesIO
+from wsgiref.util import setup_testing_defaults
+
+import pyjion
+from pyjion.wsgi import PyjionWsgiMiddleware
+
+USERS = [{"id": i, "name": f"user{i}", "email": f"user{i}@example.com", "score": i * 7 % 101} for i in range(200)]
+
+
+class Template:
+    """Minimal template engine, supports {{ name }} substitution and {% for x in items %}...{% endfor %} loops."""
+    _loop = re.compile(r"{% for (\w+) in (\w+) %}(.*?){% endfor %}", re.S)
+    _var = re.compile(r"{{ ([\w.]+) }}")
+
+    def __init__(self, source):
+        self.source = source
+
+    def _lookup(self, name, context):
+        value = context
+        for part in name.split("."):
+            value = value[part]
+        return escape(str(value))
+
+    def _substitute(self, text, context):
+        return self._var.sub(lambda m: self._lookup(m.group(1), context), text)
+
+    def render(self, context):
+        def loop(m):
+            var, items, body = m.groups()
+            return "".join(self._substitute(body, {**context, var: item}) for item in context[items])
+        return self._substitute(self._loop.sub(loop, self.source), context)
+
+
+USER_LIST = Template("""<html><head><title>{{ title }}</title></head><body>
+<h1>{{ title }}</h1>
+<table>
+{% for user in users %}<tr><td>{{ user.id }}</td><td>{{ user.name }}</td><td>{{ user.email }}</td><td>{{ user.score }}</td></tr>
+{% endfor %}</table></body></html>""")
+
+
+class Router:
+    def __init__(self):
+        self.routes = []
+
+    def route(self, pattern):
+        def decorator(f):
+            self.routes.append((re.compile(f"^{pattern}$"), f))
+            return f
+        return decorator
+
+    def match(self, path):
+        for regex, handler in self.routes:
+            m = regex.match(path)
+            if m:
+                return handler, m.groupdict()
+        return None, {}
+
+
+router = Router()
+
+
+@router.route("/")
+def index(environ):
+    return "200 OK", "text/html", USER_LIST.render({"title": "Users", "users": USERS[:50]})
+
+
+@router.route("/api/users")
+def api_users(environ):
+    limit = int(environ.get("QUERY_STRING", "").partition("limit=")[2] or 20)
+    return "200 OK", "application/json", json.dumps({"users": USERS[:limit], "count": limit})
+
+
+@router.route(r"/api/users/(?P<user_id>\d+)")
+def api_user(environ, user_id):
+    user_id = int(user_id)
+    if user_id >= len(USERS):
+        return "404 Not Found", "application/json", json.dumps({"error": "not found"})
+    return "200 OK", "application/json", json.dumps(USERS[user_id])
+
+
+@router.route("/api/echo")
+def api_echo(environ):
+    length = int(environ.get("CONTENT_LENGTH") or 0)
+    body = json.loads(environ["wsgi.input"].read(length))
+    body["total"] = sum(body.get("values", []))
+    return "200 OK", "application/json", json.dumps(body)
+
+
+def application(environ, start_response):
+    handler, kwargs = router.match(environ["PATH_INFO"])
+    if handler is None:
+        start_response("404 Not Found", [("Content-Type", "text/plain")])
+        return [b"Not Found"]
+    status, content_type, body = handler(environ, **kwargs)
+    data = body.encode("utf-8")
+    start_response(status, [("Content-Type", content_type), ("Content-Length", str(len(data)))])
+    return [data]
+
+
+REQUESTS = [
+    ("GET", "/", "", b""),
+    ("GET", "/api/users", "limit=20", b""),
+    ("GET", "/api/users/42", "", b""),
+    ("GET", "/api/users/1000", "", b""),
+    ("POST", "/api/echo", "", json.dumps({"name": "test", "values": list(range(50))}).encode()),
+    ("GET", "/missing", "", b""),
+]
+
+
+def make_environ(method, path, query, body):
+    environ = {
+        "REQUEST_METHOD": method,
+        "PATH_INFO": path,
+        "QUERY_STRING": query,
+        "CONTENT_LENGTH": str(len(body)),
+        "wsgi.input": BytesIO(body),
+    }
+    setup_testing_defaults(environ)
+    return environ
+
+
+def serve(app, n):
+    """Fake server loop, returns the latency (in seconds) of each request."""
+    latencies = []
+    status_holder = []
+
+    def start_response(status, headers, exc_info=None):
+        status_holder.append(status)
+
+    for i in range(n):
+        environ = make_environ(*REQUESTS[i % len(REQUESTS)])
+        start = time.perf_counter()
+        result = app(environ, start_response)
+        for chunk in result:
+            pass
+        if hasattr(result, "close"):
+            result.close()
+        latencies.append(time.perf_counter() - start)
+    return latencies
+
+
+def percentile(sorted_values, p):
+    k = (len(sorted_values) - 1) * p
+    f = int(k)
+    c = min(f + 1, len(sorted_values) - 1)
+    return sorted_values[f] + (sorted_values[c] - sorted_values[f]) * (k - f)
+
+
+def windows(latencies, size):
+    result = []
+    for start in range(0, len(latencies), size):
+        window = sorted(latencies[start:start + size])
+        result.append({
+            "requests": start + len(window),
+            "rps": len(window) / sum(window),
+            "p50": percentile(window, 0.5),
+            "p99": percentile(window, 0.99),
+        })
+    return result
+
+
+def bench_wsgi(n=1000):
+    serve(application, n)
+
+
+__benchmarks__ = [(bench_wsgi, "wsgi", {"level": 2, "pgc": True}, 5)]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="WSGI workload benchmark")
+    parser.add_argument("-n", "--requests", type=int, default=20000)
+    parser.add_argument("-w", "--window", type=int, default=1000, help="Requests per reporting window")
+    parser.add_argument("--level", type=int, default=2)
+    parser.add_argument("-o", "--output", help="Write the time series as JSON to this file")
+    args = parser.parse_args()
+
+    without = windows(serve(application, args.requests), args.window)
+    pyjion.config(level=args.level)
+    jitted_app = PyjionWsgiMiddleware(application)
+    try:
+        with_jit = windows(serve(jitted_app, args.requests), args.window)
+    finally:
+        pyjion.disable()
+
+    print(f"{'Requests':>9} {'req/s':>10} {'p50 (us)':>10} {'p99 (us)':>10} | {'req/s (+)':>10} {'p50 (+)':>10} {'p99 (+)':>10}")
+    for a, b in zip(without, with_jit):
+        print(f"{a['requests']:>9} {a['rps']:>10.0f} {a['p50'] * 1e6:>10.1f} {a['p99'] * 1e6:>10.1f} | "
+              f"{b['rps']:>10.0f} {b['p50'] * 1e6:>10.1f} {b['p99'] * 1e6:>10.1f}")
+
+    if args.output:
+        with open(args.output, "w") as out:
+            json.dump({"window": args.window, "without": without, "with": with_jit}, out, indent=2)
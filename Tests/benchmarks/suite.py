@@ -1,106 +1,383 @@
 """
 A benchmark suite for Pyjion
+
+Usage:
+
+    python suite.py [benchmark] [--output results.json] [--profile]
+    python suite.py compare baseline.json candidate.json [--alpha 0.05] [--threshold 5.0]
+
+Each benchmark is executed with and without Pyjion. The first calls (which include compilation, and for PGC
+the profiling pass and recompilation) are timed separately as "warmup" and are never mixed into the
+steady-state samples.
 """
+import argparse
+import cProfile
+import gc
+import json
+import math
+import os
+import pathlib
+import platform
+import resource
+import sys
+import time
 import timeit
 import warnings
-
 from contextlib import redirect_stdout
+from statistics import fmean, median, stdev
 
 import pyjion
 import pyjion.dis
-import pathlib
-import sys
-from statistics import fmean
 from rich.console import Console
 from rich.table import Table
 from rich.text import Text
-import cProfile
 
-REPEAT = 5
-TIMES = 5
+SCHEMA_VERSION = 1
+DEFAULT_ALPHA = 0.05
+DEFAULT_THRESHOLD = 5.0  # Minimum relative slowdown (%) to be reported as a regression
 
-if __name__ == "__main__":
-    table = Table(title=f"Pyjion Benchmark Suite, repeat={REPEAT}, number={TIMES}")
 
+def rss_bytes() -> int:
+    """Current resident set size of this process, falls back to the peak RSS where /proc is unavailable."""
+    try:
+        with open("/proc/self/statm") as statm:
+            return int(statm.read().split()[1]) * os.sysconf("SC_PAGE_SIZE")
+    except (OSError, ValueError):
+        return peak_rss_bytes()
+
+
+def peak_rss_bytes() -> int:
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # ru_maxrss is in bytes on macOS and kilobytes everywhere else
+    return peak if sys.platform == "darwin" else peak * 1024
+
+
+def walk_code(code):
+    yield code
+    for const in code.co_consts:
+        if hasattr(const, "co_code"):
+            yield from walk_code(const)
+
+
+def module_code_objects(module):
+    seen = set()
+    for attrib in module.__dict__.values():
+        code = getattr(attrib, "__code__", None)
+        if code is None or getattr(attrib, "__module__", None) != module.__name__:
+            continue
+        for c in walk_code(code):
+            if id(c) not in seen:
+                seen.add(id(c))
+                yield c
+
+
+def jit_stats(module) -> dict:
+    """Summarise the JIT state of every code object in the benchmark module."""
+    stats = {
+        "functions": 0,
+        "compiled": 0,
+        "failed": 0,
+        "il_bytes": 0,
+        "native_bytes": 0,
+        "compile_results": {},
+        "pgc": {},
+        "optimizations": {},
+        "details": [],
+    }
+    for code in module_code_objects(module):
+        info = pyjion.info(code)
+        if info.run_count == 0 and not info.compiled:
+            continue  # never executed by this benchmark
+        stats["functions"] += 1
+        il_size = native_size = 0
+        if info.compiled:
+            stats["compiled"] += 1
+            il = pyjion.il(code)
+            native = pyjion.native(code)
+            il_size = len(il) if il else 0
+            native_size = native[1] if native else 0
+            stats["il_bytes"] += il_size
+            stats["native_bytes"] += native_size
+        if info.failed:
+            stats["failed"] += 1
+            reason = info.compile_result.name
+            stats["compile_results"][reason] = stats["compile_results"].get(reason, 0) + 1
+        stats["pgc"][info.pgc.name] = stats["pgc"].get(info.pgc.name, 0) + 1
+        for flag in pyjion.OptimizationFlags:
+            if flag in info.optimizations:
+                stats["optimizations"][flag.name] = stats["optimizations"].get(flag.name, 0) + 1
+        stats["details"].append({
+            "name": code.co_name,
+            "line": code.co_firstlineno,
+            "compiled": info.compiled,
+            "compile_result": info.compile_result.name,
+            "pgc": info.pgc.name,
+            "optimizations": int(info.optimizations),
+            "run_count": info.run_count,
+            "il_bytes": il_size,
+            "native_bytes": native_size,
+        })
+    return stats
+
+
+def distribution(samples, number) -> dict:
+    per_call = [s / number for s in samples]
+    return {
+        "samples": per_call,
+        "min": min(per_call),
+        "max": max(per_call),
+        "mean": fmean(per_call),
+        "median": median(per_call),
+        "stdev": stdev(per_call) if len(per_call) > 1 else 0.0,
+    }
+
+
+def measure(func, repeat: int, number: int, warmup_calls: int) -> dict:
+    gc.collect()
+    rss_before = rss_bytes()
+    warmup = []
+    for _ in range(warmup_calls):
+        start = time.perf_counter()
+        func()
+        warmup.append(time.perf_counter() - start)
+    steady = timeit.repeat(func, repeat=repeat, number=number)
+    return {
+        "warmup": warmup,
+        "steady": distribution(steady, number),
+        "rss_before": rss_before,
+        "rss_after": rss_bytes(),
+    }
+
+
+def run_benchmark(module, func, desc, settings, repeat, args) -> dict:
+    # Every compiled function needs to pass through the threshold and, with PGC, one profiling call.
+    warmup_calls = settings.get("threshold", 0) + (2 if settings.get("pgc", True) else 1)
+    number = args.number or repeat
+
+    without_result = measure(func, repeat, number, warmup_calls)
+
+    pyjion.enable()
+    pyjion.config(**settings, graph=True)
+    try:
+        with_result = measure(func, repeat, number, warmup_calls)
+    finally:
+        pyjion.disable()
+    stats = jit_stats(module)
+    with_result["jit"] = stats
+    with_result["jit_heap"] = stats["il_bytes"] + stats["native_bytes"]
+
+    if args.profile:
+        # Profiled runs are kept apart from the timed ones, the profiler overhead would skew the samples
+        with cProfile.Profile() as pr:
+            timeit.repeat(func, repeat=repeat, number=number)
+        pr.dump_stats(args.profiles / f'{module.__name__}_{desc}_without.pstat')
+        pyjion.enable()
+        pyjion.config(**settings)
+        with cProfile.Profile() as pr:
+            timeit.repeat(func, repeat=repeat, number=number)
+        pyjion.disable()
+        pr.dump_stats(args.profiles / f'{module.__name__}_{desc}_with.pstat')
+
+    with open(args.profiles / f'{module.__name__}_{desc}.cil', 'w') as il:
+        with redirect_stdout(il):
+            pyjion.dis.dis(func)
+
+    return {
+        "module": module.__name__,
+        "name": desc,
+        "settings": settings,
+        "repeat": repeat,
+        "number": number,
+        "without": without_result,
+        "with": with_result,
+    }
+
+
+def write_graphs(module, graphs_out: pathlib.Path):
+    with open(graphs_out / f'{module.__name__}.dot', 'w') as dot:
+        for k, attrib in module.__dict__.items():
+            if hasattr(attrib, "__code__"):
+                if pyjion.info(attrib.__code__).failed:
+                    warnings.warn(
+                        f"Failed to compile {attrib.__code__} with result {pyjion.info(attrib.__code__).compile_result}")
+                else:
+                    g = pyjion.graph(attrib.__code__)
+                    if g:
+                        dot.write(g)
+                        dot.write('')
+
+
+def delta_text(with_value, without_value) -> Text:
+    delta = (abs(with_value - without_value) / without_value) * 100.0
+    if with_value < without_value:
+        return Text(f"{with_value:.5f} ({delta:.1f}%)", style="green")
+    return Text(f"{with_value:.5f} (-{delta:.1f}%)", style="red")
+
+
+def run(args):
+    here = pathlib.Path(__file__).parent
+    graphs_out = here / 'graphs'
+    graphs_out.mkdir(exist_ok=True)
+    args.profiles = here / 'profiles'
+    args.profiles.mkdir(exist_ok=True)
+
+    table = Table(title="Pyjion Benchmark Suite (seconds per call, steady-state)")
     table.add_column("Benchmark", justify="right", style="cyan", no_wrap=True)
     table.add_column("Repeat", style="magenta")
-    table.add_column("Min", style="magenta", width=7)
-    table.add_column("Max", style="magenta", width=7)
-    table.add_column("Mean", style="magenta", width=7)
-    table.add_column("Min (+)", style="blue", width=15)
-    table.add_column("Max (+)", style="blue", width=15)
-    table.add_column("Mean (+)", style="blue", width=15)
-
-    graphs_out = pathlib.Path(__file__).parent / 'graphs'
-    if not graphs_out.exists():
-        graphs_out.mkdir()
-    profiles_out = pathlib.Path(__file__).parent / 'profiles'
-    if not profiles_out.exists():
-        profiles_out.mkdir()
-
-    for f in pathlib.Path(__file__).parent.glob("bench_*.py"):
-        if len(sys.argv) > 1 and f.stem != f"bench_{sys.argv[1]}":
+    table.add_column("Warmup", style="magenta", width=9)
+    table.add_column("Median", style="magenta", width=9)
+    table.add_column("Stdev", style="magenta", width=9)
+    table.add_column("Warmup (+)", style="blue", width=9)
+    table.add_column("Median (+)", style="blue", width=18)
+    table.add_column("Stdev (+)", style="blue", width=9)
+    table.add_column("JIT code bytes", style="blue", width=14)
+
+    results = []
+    for f in sorted(here.glob("bench_*.py")):
+        if args.benchmark and f.stem != f"bench_{args.benchmark}":
             continue
         i = __import__(f.stem, globals(), locals(), )
-        if hasattr(i, "__benchmarks__"):
-            for benchmark in i.__benchmarks__:
-                func, desc, settings, repeat = benchmark
-                with cProfile.Profile() as pr:
-                    without_result = timeit.repeat(func, repeat=repeat, number=repeat)
-
-                pr.dump_stats(profiles_out / f'{f.stem}_{desc}_without.pstat')
-
-                with cProfile.Profile() as pr:
-                    pyjion.enable()
-                    pyjion.config(**settings, graph=True)
-                    with_result = timeit.repeat(func, repeat=repeat, number=repeat)
-                    pyjion.disable()
-                    pr.dump_stats(profiles_out / f'{f.stem}_{desc}_with.pstat')
-
-                with open(profiles_out / f'{f.stem}_{desc}.cil', 'w') as il:
-                    with redirect_stdout(il):
-                        pyjion.dis.dis(func)
-
-                with open(graphs_out / f'{f.stem}.dot', 'w') as dot:
-                    for k, attrib in i.__dict__.items():
-                        if hasattr(attrib, "__code__"):
-                            if pyjion.info(attrib.__code__).failed:
-                                warnings.warn(
-                                    f"Failed to compile {attrib.__code__} with result {pyjion.info(attrib.__code__).compile_result}")
-                            else:
-                                g = pyjion.graph(attrib.__code__)
-                                if g:
-                                    dot.write(g)
-                                    dot.write('')
-
-                delta_mean = (abs(fmean(with_result) - fmean(without_result)) / fmean(without_result)) * 100.0
-                delta_min = (abs(min(with_result) - min(without_result)) / min(without_result)) * 100.0
-                delta_max = (abs(max(with_result) - max(without_result)) / max(without_result)) * 100.0
-
-                if min(with_result) < min(without_result):
-                    fdelta_min = Text(f"{min(with_result):.3f} ({delta_min:.1f}%)", style="green")
-                else:
-                    fdelta_min = Text(f"{min(with_result):.3f} (-{delta_min:.1f}%)", style="red")
+        if not hasattr(i, "__benchmarks__"):
+            continue
+        for func, desc, settings, repeat in i.__benchmarks__:
+            result = run_benchmark(i, func, desc, settings, args.repeat or repeat, args)
+            results.append(result)
+            without_result, with_result = result["without"], result["with"]
+            table.add_row(desc,
+                          str(result["repeat"]),
+                          "{:.5f}".format(sum(without_result["warmup"])),
+                          "{:.5f}".format(without_result["steady"]["median"]),
+                          "{:.5f}".format(without_result["steady"]["stdev"]),
+                          "{:.5f}".format(sum(with_result["warmup"])),
+                          delta_text(with_result["steady"]["median"], without_result["steady"]["median"]),
+                          "{:.5f}".format(with_result["steady"]["stdev"]),
+                          f"{with_result['jit_heap'] // 1024}KiB",
+                          )
+        write_graphs(i, graphs_out)
 
-                if max(with_result) < max(without_result):
-                    fdelta_max = Text(f"{max(with_result):.3f} ({delta_max:.1f}%)", style="green")
-                else:
-                    fdelta_max = Text(f"{max(with_result):.3f} (-{delta_max:.1f}%)", style="red")
+    console = Console(width=150)
+    console.print(table)
+
+    if args.output:
+        document = {
+            "version": SCHEMA_VERSION,
+            "python": sys.version,
+            "platform": platform.platform(),
+            "machine": platform.machine(),
+            "timestamp": time.time(),
+            "peak_rss": peak_rss_bytes(),
+            "benchmarks": results,
+        }
+        with open(args.output, 'w') as out:
+            json.dump(document, out, indent=2)
+        console.print(f"Results written to {args.output}")
 
-                if fmean(with_result) < fmean(without_result):
-                    fdelta_mean = Text(f"{fmean(with_result):.3f} ({delta_mean:.1f}%)", style="green")
-                else:
-                    fdelta_mean = Text(f"{fmean(with_result):.3f} (-{delta_mean:.1f}%)", style="red")
-
-                table.add_row(desc,
-                              str(repeat),
-                              "{:.3f}".format(min(without_result)),
-                              "{:.3f}".format(max(without_result)),
-                              "{:.3f}".format(fmean(without_result)),
-                              fdelta_min,
-                              fdelta_max,
-                              fdelta_mean,
-                              )
+
+def mann_whitney_u(a, b) -> float:
+    """
+    Two-sided Mann-Whitney U test using the normal approximation (with tie correction).
+    Returns the p-value, the samples don't need to be normally distributed.
+    """
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    combined = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    ranks = [0.0] * len(combined)
+    ties = 0.0
+    i = 0
+    while i < len(combined):
+        j = i
+        while j + 1 < len(combined) and combined[j + 1][0] == combined[i][0]:
+            j += 1
+        rank = (i + j) / 2.0 + 1.0
+        for k in range(i, j + 1):
+            ranks[k] = rank
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+    r1 = sum(r for r, (_, group) in zip(ranks, combined) if group == 0)
+    u1 = r1 - n1 * (n1 + 1) / 2.0
+    n = n1 + n2
+    mu = n1 * n2 / 2.0
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)))) if n > 1 else 0.0
+    if sigma == 0.0:
+        return 1.0
+    z = (abs(u1 - mu) - 0.5) / sigma
+    return max(0.0, min(1.0, math.erfc(z / math.sqrt(2.0))))
+
+
+def compare(args):
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.candidate) as f:
+        candidate = json.load(f)
+
+    base_index = {(b["module"], b["name"]): b for b in baseline["benchmarks"]}
+
+    table = Table(title=f"Pyjion benchmark comparison (alpha={args.alpha}, threshold={args.threshold}%)")
+    table.add_column("Benchmark", justify="right", style="cyan", no_wrap=True)
+    table.add_column("Baseline", style="magenta")
+    table.add_column("Candidate", style="magenta")
+    table.add_column("Change", width=9)
+    table.add_column("p-value", width=9)
+    table.add_column("Warmup change", width=14)
+    table.add_column("JIT code bytes change", width=21)
+    table.add_column("Verdict")
+
+    regressions = 0
+    for bench in candidate["benchmarks"]:
+        base = base_index.get((bench["module"], bench["name"]))
+        if base is None:
+            continue
+        before, after = base["with"]["steady"], bench["with"]["steady"]
+        change = (after["median"] - before["median"]) / before["median"] * 100.0
+        p = mann_whitney_u(before["samples"], after["samples"])
+        warmup_change = sum(bench["with"]["warmup"]) - sum(base["with"]["warmup"])
+        heap_change = bench["with"]["jit_heap"] - base["with"]["jit_heap"]
+
+        if p < args.alpha and change > args.threshold:
+            verdict = Text("regression", style="bold red")
+            regressions += 1
+        elif p < args.alpha and change < -args.threshold:
+            verdict = Text("improvement", style="green")
+        else:
+            verdict = Text("no significant change")
+        table.add_row(bench["name"],
+                      "{:.5f}".format(before["median"]),
+                      "{:.5f}".format(after["median"]),
+                      f"{change:+.1f}%",
+                      f"{p:.3f}",
+                      f"{warmup_change:+.4f}s",
+                      f"{heap_change:+d}B",
+                      verdict)
 
     console = Console(width=150)
     console.print(table)
+    if regressions:
+        console.print(Text(f"{regressions} significant regression(s) found", style="bold red"))
+    return 1 if regressions else 0
+
+
+def main(argv=None):
+    argv = sys.argv[1:] if argv is None else argv
+    if argv and argv[0] == "compare":
+        parser = argparse.ArgumentParser(prog="suite.py compare", description="Compare two benchmark result files")
+        parser.add_argument("baseline")
+        parser.add_argument("candidate")
+        parser.add_argument("--alpha", type=float, default=DEFAULT_ALPHA, help="Significance level")
+        parser.add_argument("--threshold", type=float, default=DEFAULT_THRESHOLD,
+                            help="Minimum change in percent to be reported")
+        return compare(parser.parse_args(argv[1:]))
+
+    parser = argparse.ArgumentParser(prog="suite.py", description="Run the Pyjion benchmark suite")
+    parser.add_argument("benchmark", nargs="?", help="Only run bench_<benchmark>.py")
+    parser.add_argument("-o", "--output", help="Write the results as JSON to this file")
+    parser.add_argument("--repeat", type=int, help="Override the number of steady-state samples")
+    parser.add_argument("--number", type=int, help="Override the number of calls per sample")
+    parser.add_argument("--profile", action="store_true", help="Write cProfile stats for each benchmark")
+    run(parser.parse_args(argv))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
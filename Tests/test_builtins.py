@@ -391,4 +391,92 @@ def test_zip():
     zipped = zip(x, y)
     assert list(zipped) == [(1, 4), (2, 5), (3, 6)]
 
-# dont test __import__
\ No newline at end of file
+# dont test __import__
+
+def test_inline_builtins():
+    values = [3, -7, 2]
+    total = 0
+    for i in range(len(values)):
+        total += abs(values[i]) + len("abc") + len({1: 2})
+    assert total == 24
+    x = -2.5
+    y = 1.5
+    assert abs(x) + min(x, y) == 0.0
+    assert max(x, y) - 1.0 == 0.5
+    a = 3
+    b = 4
+    assert max(a, b) * min(a, b) == 12
+    nan = float("nan")
+    assert max(x, nan) == x
+    assert min(nan, x) != min(nan, x)
+
+
+def test_inline_isinstance():
+    class MyInt(int):
+        pass
+
+    class Fake:
+        __class__ = list
+
+    assert isinstance(MyInt(2), int) == True
+    assert isinstance(True, int) == True
+    assert isinstance("s", int) == False
+    assert isinstance(Fake(), list) == True
+    assert isinstance([1], (list, tuple)) == True
+
+
+def test_inline_builtins_shadowed():
+    def len(x):
+        return 42
+
+    assert len([1, 2]) + 1 == 43
+    global abs
+    abs = lambda v: 100
+    try:
+        x = -1
+        assert abs(x) + 1 == 101
+    finally:
+        del abs
+    x = -1
+    assert abs(x) + 1 == 2
+
+
+def test_inline_conversions():
+    total = 0.0
+    for i in range(5):
+        total += float(i) * 0.5
+    assert total == 5.0
+    x = -2.75
+    y = 1.5
+    assert int(x + y) == -1
+    assert int(y * 4.0) + 1 == 7
+    assert bool(x + y) == True
+    assert bool(y - y) == False
+    assert bool(x * float("nan")) == True
+    a = 12
+    b = -30
+    assert str(a + b) == "-18"
+    assert str(a * 0) == "0"
+    assert int(a + b) * 2 == -36
+    assert float(a > b) + 1.0 == 2.0
+
+
+def test_inline_conversion_errors():
+    x = 2.0 ** 61
+    assert int(x * 2.0) - 1 == 4611686018427387903
+    y = float("inf")
+    with pytest.raises(OverflowError):
+        int(y * 2.0)
+    with pytest.raises(ValueError):
+        int(y - y)
+
+
+def test_inline_int_of_large_float():
+    def _f(x):
+        return int(x * 2.0)
+
+    assert _f(5e19) == 100000000000000000000
+    assert _f(-5e19) == -100000000000000000000
+    assert _f(1.25) == 2
+    z = 1e20
+    assert int(z + 0.0) == 10 ** 20
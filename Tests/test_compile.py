@@ -0,0 +1,80 @@
+import sys
+import types
+import pyjion
+import pytest
+
+
+def test_compile_before_call():
+    def _f(a, b):
+        return a + b
+
+    # The JIT state lives on the code object, which is shared by every run of a test
+    f = types.FunctionType(_f.__code__.replace(), _f.__globals__)
+    assert pyjion.compile(f)
+    info = pyjion.info(f)
+    assert info.compiled
+    assert info.pgc == pyjion.PgcStatus.Optimized
+    assert info.run_count == 0
+    assert f(1, 2) == 3
+    assert f("a", "b") == "ab"
+
+
+def test_compile_arg_types():
+    def _f(a, b):
+        return a * b + 1.0
+
+    assert pyjion.compile(_f, arg_types=(float, float))
+    assert _f(2.0, 3.0) == 7.0
+
+
+def test_compile_arg_types_dict():
+    def _f(a, b):
+        return a - b
+
+    assert pyjion.compile(_f, arg_types={"b": int})
+    assert _f(5, 3) == 2
+
+
+def test_compile_arg_types_big_int():
+    def _f(a, b):
+        return a * b + 1
+
+    assert pyjion.compile(_f, arg_types=(int, int))
+    assert _f(2, 3) == 7
+    assert _f(2 ** 70, 3) == 3 * 2 ** 70 + 1
+
+
+def test_compile_wrong_arg_types():
+    def _f(a, b):
+        return a + b
+
+    assert pyjion.compile(_f, arg_types=(int, int))
+    assert _f("a", "b") == "ab"
+
+
+def test_compile_invalid_arg_types():
+    def _f(a):
+        return a
+
+    with pytest.raises(TypeError):
+        pyjion.compile(_f, arg_types=(1,))
+
+
+def test_compile_module():
+    results = pyjion.compile_module(sys.modules[__name__], recursive=False)
+    assert results["test_compile_before_call"]
+    assert "test_compile_before_call._f" not in results
+    assert pyjion.info(test_compile_arg_types).compiled
+
+
+def test_compile_module_recursive():
+    results = pyjion.compile_module(sys.modules[__name__])
+    assert "test_compile_before_call._f" in results
+
+
+def test_compile_module_workers():
+    results = pyjion.compile_module(sys.modules[__name__], workers=4)
+    assert results["test_compile_before_call"]
+    assert "test_compile_before_call._f" in results
+    assert pyjion.info(test_compile_arg_types).compiled
+    assert pyjion.info(test_compile_arg_types).pgc == pyjion.PgcStatus.Optimized
@@ -56,6 +56,8 @@ def test_dict_comprehensions():
     assert {k : v * 2 for k,v in dict1.items()} == {'a': 2, 'b': 4, 'c': 6, 'd': 8, 'e': 10}
     assert dict({k: v for k, v in enumerate((1,2,3,))}) == {0: 1, 1: 2, 2: 3}
     assert {k: k + 10 for k in range(10)} == {0: 10, 1: 11, 2: 12, 3: 13, 4: 14, 5: 15, 6: 16, 7: 17, 8: 18, 9: 19}
+    assert {k: str(k) for k in [1, 2, 1]} == {1: '1', 2: '2'}
+    assert {k: k for k in range(10000) if k == 5000} == {5000: 5000}
 
 def test_dict_unpacking():
     assert {'c': 'carrot', **{'b': 'banana'}, 'a': 'apple'} == {'c': 'carrot', 'b': 'banana', 'a': 'apple'}
@@ -306,3 +308,67 @@ def test_large_const_dict():
         "grey93": 255,
     }
     assert ANSI_COLOR_NAMES['white'] == 7
+
+
+def test_dict_items_loop():
+    d = {'a': 1, 'b': 2, 'c': 3}
+    result = []
+    for k, v in d.items():
+        result.append((k, v))
+    assert result == [('a', 1), ('b', 2), ('c', 3)]
+
+
+def test_dict_keys_values_loop():
+    d = {'a': 1, 'b': 2}
+    keys = []
+    values = []
+    for k in d:
+        keys.append(k)
+    for k in d.keys():
+        keys.append(k)
+    for v in d.values():
+        values.append(v)
+    assert keys == ['a', 'b', 'a', 'b']
+    assert values == [1, 2]
+
+
+def test_dict_items_not_unpacked():
+    d = {'a': 1}
+    result = []
+    for kv in d.items():
+        result.append(kv)
+    assert result == [('a', 1)]
+
+
+def test_dict_tuple_keys_unpacked():
+    d = {(1, 2): 'x'}
+    result = []
+    for a, b in d.keys():
+        result.append(a + b)
+    assert result == [3]
+
+
+def test_dict_changed_size_during_loop():
+    d = {'a': 1, 'b': 2}
+    with pytest.raises(RuntimeError):
+        for k, v in d.items():
+            d[k + k] = v
+
+
+def test_dict_keys_changed_during_loop():
+    d = {'a': 1, 'b': 2}
+    with pytest.raises(RuntimeError):
+        for k in d:
+            del d[k]
+            d[k + k] = 1
+
+
+def test_dict_items_refcount():
+    a = object()
+    before = sys.getrefcount(a)
+    d = {'x': a, 'y': a}
+    for k, v in d.items():
+        pass
+    del v
+    del d
+    assert sys.getrefcount(a) == before
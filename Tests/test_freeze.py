@@ -0,0 +1,62 @@
+import subprocess
+import sys
+import textwrap
+
+import pytest
+
+
+@pytest.mark.skipif(sys.platform == "win32", reason="requires os.fork()")
+def test_freeze_then_fork():
+    # Freezing can't be undone, so it runs in its own interpreter
+    script = textwrap.dedent("""
+        import os
+        import pyjion
+
+        def f(a, b):
+            return a * b + 1
+
+        def g(a):
+            return a - 1
+
+        pyjion.enable()
+        assert pyjion.compile(f)
+        assert pyjion.freeze()
+        assert not pyjion.freeze()
+        assert pyjion.config()["frozen"]
+        pid = os.fork()
+        if pid == 0:
+            ok = f(2, 3) == 7 and g(2) == 1 and pyjion.info(f).run_count == 0 and not pyjion.info(g).compiled
+            os._exit(0 if ok else 1)
+        _, status = os.waitpid(pid, 0)
+        assert os.WEXITSTATUS(status) == 0
+        assert f(3, 3) == 10
+        pyjion.disable()
+    """)
+    result = subprocess.run([sys.executable, "-c", script], capture_output=True, text=True)
+    assert result.returncode == 0, result.stderr
+
+
+def test_compile_after_freeze():
+    script = textwrap.dedent("""
+        import sys
+        import pyjion
+
+        def f(a, b):
+            return a * b + 1
+
+        def g(a):
+            return a - 1
+
+        pyjion.enable()
+        assert pyjion.compile(f)
+        assert pyjion.freeze()
+        heap = pyjion.stats()["code_heap_bytes"]
+        assert not pyjion.compile(g)
+        assert not any(pyjion.compile_module(sys.modules[__name__], workers=2).values())
+        assert not pyjion.info(g).compiled
+        assert pyjion.stats()["code_heap_bytes"] == heap
+        assert f(2, 3) == 7 and g(2) == 1
+        pyjion.disable()
+    """)
+    result = subprocess.run([sys.executable, "-c", script], capture_output=True, text=True)
+    assert result.returncode == 0, result.stderr
@@ -1023,3 +1023,100 @@ class TestObjectMethodCalls:
         assert sys.getrefcount(arg1) == pre_refcnt_a
         info = pyjion.info(self.test_arg15_cfunction_exc.__code__)
         assert info.compiled, info.compile_result
+
+
+def _hypot2(x, y):
+    return x * x + y * y
+
+
+def _fib(n):
+    if n < 2:
+        return n
+    return _fib(n - 1) + _fib(n - 2)
+
+
+def _checked(i):
+    if i > 10:
+        raise ValueError(i)
+    return i * 2
+
+
+def _lerp(a, b, t):
+    return a + (b - a) * t
+
+
+def _scale(x):
+    return x * 1.5
+
+
+class TestDirectCalls:
+
+    def test_unboxed_int_result(self):
+        def f(n):
+            total = 0
+            for i in range(n):
+                total += _hypot2(i, i + 1) + 1
+            return total
+
+        for _ in range(5):
+            assert f(100) == sum(i * i + (i + 1) * (i + 1) + 1 for i in range(100))
+        assert pyjion.info(_hypot2).direct
+        assert _fib(20) == 6765
+        assert _fib(20) == 6765
+
+    def test_unboxed_float_result(self):
+        def f(n):
+            total = 0.0
+            for i in range(n):
+                total += _scale(float(i)) * 2.0
+            return total
+
+        for _ in range(5):
+            assert f(10) == 135.0
+
+    def test_exception_in_callee(self):
+        def f(n):
+            total = 0
+            for i in range(n):
+                total += _checked(i) + 1
+            return total
+
+        for _ in range(5):
+            assert f(5) == 25
+        with pytest.raises(ValueError):
+            f(20)
+
+    def test_rebound_function(self):
+        global _scale
+
+        def f(x):
+            return _scale(x) + 1.0
+
+        for _ in range(5):
+            assert f(2.0) == 4.0
+        previous = _scale
+        try:
+            _scale = lambda x: x * 3.0
+            assert f(2.0) == 7.0
+            _scale = abs
+            assert f(-2.0) == 3.0
+        finally:
+            _scale = previous
+        assert f(2.0) == 4.0
+
+    def test_unboxed_arguments(self):
+        def f(n):
+            total = 0.0
+            for i in range(n):
+                x = float(i)
+                total += _lerp(x, x + 2.0, 0.25) * 2.0
+            return total
+
+        def g(a, b):
+            return _lerp(a, b, 0.5) + 1.0
+
+        for _ in range(5):
+            assert f(10) == sum((i + 0.5) * 2.0 for i in range(10))
+        # Arguments of another kind than the direct variant takes go through the regular entry point
+        for _ in range(5):
+            assert g(1, 3) == 3.0
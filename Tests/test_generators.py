@@ -1,4 +1,9 @@
 from io import StringIO
+import subprocess
+import sys
+import textwrap
+import types
+import pytest
 import pyjion
 
 
@@ -193,3 +198,165 @@ def test_nested_generator_calling_uncompiled_function():
     assert list(gen) == ['!hello', '@hello', '#hello', '%hello', '$hello', '^hello']
     assert pyjion.info(cr1).failed
     assert not pyjion.info(cr2).failed
+
+
+
+def _genexpr(f):
+    for const in f.__code__.co_consts:
+        if isinstance(const, types.CodeType) and const.co_name == "<genexpr>":
+            return const
+
+
+def test_sum_genexpr():
+    def _f(l):
+        return sum(x * 2 for x in l)
+
+    assert _f([1, 2, 3]) == 12
+    assert _f([]) == 0
+    assert _f([sys.maxsize, sys.maxsize]) == sys.maxsize * 4
+    assert _f([1, 2.5]) == 7.0
+    assert _f([0.5, True, 2 ** 70]) == 3.0 + 2 ** 71
+    with pytest.raises(TypeError):
+        _f(["a", "b"])
+    inf = pyjion.info(_f)
+    assert inf.optimizations & pyjion.OptimizationFlags.InlineIterators
+    assert pyjion.info(_genexpr(_f)).consumer
+
+
+def test_any_all_genexpr_stop_early():
+    def _any(l, seen):
+        return any(seen.append(x) or x > 2 for x in l)
+
+    def _all(l, seen):
+        return all(seen.append(x) or x < 2 for x in l)
+
+    seen = []
+    assert _any([1, 2, 3, 4], seen) is True
+    assert seen == [1, 2, 3]
+    seen = []
+    assert _any([1, 2], seen) is False
+    assert seen == [1, 2]
+    seen = []
+    assert _all([1, 2, 3], seen) is False
+    assert seen == [1, 2]
+    assert _all([], []) is True
+    assert pyjion.info(_genexpr(_any)).consumer
+
+
+def test_min_max_genexpr():
+    def _min(l):
+        return min(x for x in l)
+
+    def _max(l):
+        return max(-x for x in l)
+
+    assert _min([3, 1, 2]) == 1
+    assert _min([3.5, 1.5, 2]) == 1.5
+    assert _min(["b", "a"]) == "a"
+    assert _max([3, 1, 2]) == -1
+    assert _max([0.5, 1.5]) == -0.5
+    with pytest.raises(ValueError, match="min\\(\\) arg is an empty sequence"):
+        _min([])
+    with pytest.raises(TypeError):
+        _max([1, "a"])
+
+
+def test_containers_from_genexpr():
+    def _f(l):
+        return list(x + 1 for x in l), tuple(x + 1 for x in l), set(x % 2 for x in l)
+
+    assert _f([1, 2, 3]) == ([2, 3, 4], (2, 3, 4), {0, 1})
+    assert _f(range(0)) == ([], (), set())
+
+
+def test_genexpr_raises():
+    def _f(l):
+        return sum(1 / x for x in l)
+
+    with pytest.raises(ZeroDivisionError):
+        _f([1, 0])
+    assert _f([1, 2]) == 1.5
+
+
+def test_nested_genexpr():
+    def _f(m):
+        return sum(sum(x for x in row) for row in m), max(x for row in m for x in row)
+
+    assert _f([[1, 2], [3, 4]]) == (10, 4)
+
+
+def test_rebound_sum():
+    def _f(l):
+        return sum(x for x in l)
+
+    assert _f([1, 2]) == 3
+    _f.__globals__['sum'] = lambda g: list(g)
+    try:
+        assert _f([1, 2]) == [1, 2]
+    finally:
+        del _f.__globals__['sum']
+    assert _f([1, 2]) == 3
+
+
+def test_genexpr_refcount():
+    def _f(l):
+        return sum(len(x) for x in l), max(x for x in l)
+
+    a = "hello"
+    b = "world!"
+    before_a = sys.getrefcount(a)
+    before_b = sys.getrefcount(b)
+    assert _f([a, b]) == (11, "world!")
+    assert sys.getrefcount(a) == before_a
+    assert sys.getrefcount(b) == before_b
+
+
+def test_nested_genexpr_traced():
+    def _f(m):
+        return sum(sum(y for y in row) for row in m)
+
+    m = [[1, 2], [3, 4], [5, 6]]
+    for _ in range(3):
+        assert _f(m) == 21
+
+    def tracer(frame, event, arg):
+        return tracer
+
+    # The outer generator expression runs with the hooks instead of as the consumer variant
+    sys.settrace(tracer)
+    try:
+        assert _f(m) == 21
+    finally:
+        sys.settrace(None)
+    assert _f(m) == 21
+
+
+def test_nested_genexpr_nojit():
+    def _f(m):
+        return sum(sum(y for y in row) for row in m), max(max(y for y in row) for row in m)
+
+    pyjion.nojit(_genexpr(_f))
+    m = [[1, 2], [3, 4], [5, 6]]
+    for _ in range(3):
+        assert _f(m) == (21, 6)
+    assert not pyjion.info(_genexpr(_f)).compiled
+
+
+def test_nested_genexpr_frozen():
+    # Freezing can't be undone, so it runs in its own interpreter
+    script = textwrap.dedent("""
+        import pyjion
+
+        def f(m):
+            return sum(sum(y for y in row) for row in m)
+
+        pyjion.enable()
+        assert pyjion.compile(f)
+        assert pyjion.freeze()
+        m = [[1, 2], [3, 4], [5, 6]]
+        for _ in range(3):
+            assert f(m) == 21
+        pyjion.disable()
+    """)
+    result = subprocess.run([sys.executable, "-c", script], capture_output=True, text=True)
+    assert result.returncode == 0, result.stderr
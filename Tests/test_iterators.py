@@ -1,3 +1,8 @@
+import sys
+import pytest
+import pyjion
+
+
 def test_nested_tuple():
     l = (1,2,3)
     for n in l:
@@ -10,3 +15,173 @@ def test_nested_list():
     for n in l:
         for x in dict(), dict():
             pass
+
+
+@pytest.mark.optimization(1)
+def test_list_iteration_optimization():
+    def _f():
+        l = [1, 2, 3]
+        total = 0
+        for n in l:
+            total += n
+        return total
+
+    assert _f() == 6
+    inf = pyjion.info(_f)
+    assert inf.compiled
+    assert inf.optimizations & pyjion.OptimizationFlags.InlineIterators
+
+
+def test_tuple_iteration():
+    t = (1, 'a', None, 2.0)
+    result = []
+    for x in t:
+        result.append(x)
+    assert result == [1, 'a', None, 2.0]
+
+
+def test_list_grows_during_iteration():
+    l = [1, 2, 3]
+    seen = []
+    for n in l:
+        seen.append(n)
+        if n < 3:
+            l.append(n + 10)
+    assert seen == [1, 2, 3, 11, 12]
+
+
+def test_list_shrinks_during_iteration():
+    l = [1, 2, 3, 4, 5]
+    seen = []
+    for n in l:
+        seen.append(n)
+        l.pop()
+    assert seen == [1, 2, 3]
+
+
+def test_list_iteration_refcount():
+    a = object()
+    before = sys.getrefcount(a)
+    l = [a, a, a]
+    for x in l:
+        pass
+    del x
+    del l
+    assert sys.getrefcount(a) == before
+
+
+def test_sequence_argument_iteration():
+    def _f(seq):
+        total = 0
+        for n in seq:
+            total += n
+        return total
+
+    for _ in range(20):
+        assert _f([1, 2, 3]) == 6
+    assert _f((1, 2)) == 3
+    assert _f({4: None, 5: None}) == 9
+    assert _f(n for n in range(4)) == 6
+
+
+def test_enumerate_list():
+    l = ['a', 'b', 'c']
+    result = []
+    for i, x in enumerate(l):
+        result.append((i, x))
+    assert result == [(0, 'a'), (1, 'b'), (2, 'c')]
+
+
+def test_enumerate_start():
+    result = []
+    for i, x in enumerate((1.0, 2.0), 10):
+        result.append((i, x))
+    assert result == [(10, 1.0), (11, 2.0)]
+
+
+def test_enumerate_range():
+    total = 0
+    for i, x in enumerate(range(5, 50, 5)):
+        total += i * x
+    assert total == sum(i * x for i, x in [(i, 5 + 5 * i) for i in range(9)])
+
+
+def test_enumerate_other_iterables():
+    result = []
+    for i, c in enumerate("ab"):
+        result.append((i, c))
+    for i, k in enumerate({'x': 1}):
+        result.append((i, k))
+    assert result == [(0, 'a'), (1, 'b'), (0, 'x')]
+
+
+def test_enumerate_counter_arithmetic():
+    xs = [3, 4, 5]
+    total = 0
+    for i, x in enumerate(xs, 1):
+        total += i * i + x
+    assert total == 26
+    assert i == 3
+    # Counters of the builtin enumerate() over other iterables are unboxed from its tuples
+    for i, c in enumerate("ab", 1000):
+        total += i
+    assert total == 2027
+    assert i == 1001
+
+
+def test_zip_lists():
+    xs = [1, 2, 3, 4]
+    ys = (10, 20, 30)
+    total = 0
+    for x, y in zip(xs, ys):
+        total += x * y
+    assert total == 140
+
+
+def test_zip_three():
+    result = []
+    for a, b, c in zip([1, 2], range(3), ('x', 'y')):
+        result.append((a, b, c))
+    assert result == [(1, 0, 'x'), (2, 1, 'y')]
+
+
+def test_zip_list_grows_during_iteration():
+    xs = [1, 2]
+    seen = []
+    for x, y in zip(xs, range(4)):
+        seen.append(x)
+        xs.append(x + 10)
+    assert seen == [1, 2, 11, 12]
+
+
+def test_zip_unpack_mismatch():
+    with pytest.raises(ValueError):
+        for a, b in zip([(1, 2, 3)]):
+            pass
+
+
+def test_enumerate_refcount():
+    a = object()
+    before = sys.getrefcount(a)
+    l = [a, a]
+    for i, x in enumerate(l):
+        pass
+    del x
+    del l
+    assert sys.getrefcount(a) == before
+
+
+def test_rebound_enumerate():
+    def _f(l):
+        result = []
+        for i, x in enumerate(l):
+            result.append((i, x))
+        return result
+
+    assert _f([5, 6]) == [(0, 5), (1, 6)]
+    _f.__globals__['enumerate'] = lambda l: [(x, x) for x in l]
+    try:
+        assert _f([5, 6]) == [(5, 5), (6, 6)]
+    finally:
+        del _f.__globals__['enumerate']
+    assert _f([5, 6]) == [(0, 5), (1, 6)]
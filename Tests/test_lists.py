@@ -1,4 +1,5 @@
 import sys
+import pytest
 
 
 def test_list_init():
@@ -61,6 +62,39 @@ def test_list_comprehension_with_generator():
     assert [i for i in range(6)] == [0, 1, 2, 3, 4, 5]
 
 
+def test_list_comprehension_presized():
+    l = [1, 2, 3]
+    assert [x * 2 for x in l] == [2, 4, 6]
+    assert [x for x in (1, "a", None)] == [1, "a", None]
+    assert [x for x in range(1000)] == list(range(1000))
+    assert [x for x in iter([1, 2])] == [1, 2]
+    assert [x for x in []] == []
+
+
+def test_list_comprehension_with_condition():
+    evens = [x for x in range(1000) if x % 100 == 0]
+    assert evens == [0, 100, 200, 300, 400, 500, 600, 700, 800, 900]
+    assert sys.getsizeof(evens) < sys.getsizeof(list(range(1000)))
+    assert [x for x in range(10) if x > 100] == []
+
+
+def test_list_comprehension_grows_source():
+    l = [1, 2]
+    assert [l.append(x + 10) or x for x in l if x < 10] == [1, 2]
+    assert l == [1, 2, 11, 12]
+    nested = [[y for y in range(x)] for x in range(4)]
+    assert nested == [[], [0], [0, 1], [0, 1, 2]]
+
+
+def test_list_comprehension_refcount():
+    a = "hello"
+    before = sys.getrefcount(a)
+    result = [x for x in [a, a, a]]
+    assert sys.getrefcount(a) == before + 3
+    del result
+    assert sys.getrefcount(a) == before
+
+
 def test_list_indexing():
     l = [4, 3, 2, 1, 0]
     assert l[0] == 4
@@ -78,4 +112,61 @@ def test_list_indexing():
 
 def test_list_unpacking():
     assert [1, *[2], 3, 4] == [1, 2, 3, 4]
-    assert [1, *{2}, 3] == [1, 2, 3]
\ No newline at end of file
+    assert [1, *{2}, 3] == [1, 2, 3]
+
+
+def test_range_index_loop():
+    def total(xs):
+        t = 0
+        for i in range(len(xs)):
+            t += xs[i]
+        return t
+
+    def dot(xs, ys):
+        t = 0
+        for i in range(len(xs)):
+            t += xs[i] * ys[i]
+        return t
+
+    def stepped(xs, start, stop, step):
+        t = 0
+        for i in range(start, stop, step):
+            t += xs[i]
+        return t
+
+    def neighbours(xs):
+        t = 0
+        for i in range(1, len(xs)):
+            t += xs[i] - xs[i - 1]
+        return t
+
+    xs = [3, 1, 4, 1, 5, 9, 2, 6]
+    for _ in range(3):
+        assert total(xs) == 31
+        assert total([]) == 0
+        assert dot(xs, [1] * len(xs)) == 31
+        assert stepped(xs, 0, 8, 2) == 14
+        assert stepped(xs, 7, -1, -1) == 31
+        assert stepped(xs, -3, 0, 1) == 17
+        assert stepped(xs, -1, -4, -1) == 17
+        assert neighbours(xs) == 3
+    with pytest.raises(IndexError):
+        dot(xs, [1, 2])
+    with pytest.raises(IndexError):
+        stepped(xs, 0, 10, 3)
+    assert total((1, 2, 3)) == 6
+
+
+def test_range_index_loop_mutated():
+    # The body calls a method, so its indexes keep their bounds checks
+    def shrinking(xs):
+        t = 0
+        for i in range(len(xs)):
+            t += xs[i]
+            if i == 1:
+                xs.clear()
+        return t
+
+    for _ in range(3):
+        with pytest.raises(IndexError):
+            shrinking([1, 2, 3, 4])
@@ -1,4 +1,6 @@
 """Test the optimization of frame locals"""
+import pyjion
+import pytest
 
 
 def test_simple_compare():
@@ -19,3 +21,102 @@ def test_simple_delete():
         return False
 
     assert not test_f()
+
+
+def test_counted_while_loop():
+    def count_up(n):
+        i = 0
+        total = 0
+        while i < n:
+            total += i
+            i += 1
+        return total
+
+    def count_down(n, stop):
+        i = n
+        total = 0
+        while stop < i:
+            total += i
+            i -= 2
+        return total
+
+    def bound_on_left(n):
+        i = 0
+        while n > i:
+            i += 3
+        return i
+
+    def skip_and_stop(n, stop):
+        i = 0
+        total = 0
+        while i < n:
+            i += 1
+            if i % 2:
+                continue
+            if i > stop:
+                break
+            total += i
+        return total
+
+    def nested(n):
+        i = 0
+        total = 0
+        while i < n:
+            j = 0
+            while j < n:
+                total += 1
+                j += 1
+            i += 1
+        return total
+
+    def bound_changes(n):
+        i = 0
+        while i < n:
+            n -= 1
+            i += 1
+        return i
+
+    for _ in range(3):
+        assert count_up(100) == 4950
+        assert count_up(0) == 0
+        assert count_up(-5) == 0
+        assert bound_on_left(10) == 12
+        assert skip_and_stop(20, 9) == 20
+        assert skip_and_stop(6, 100) == 12
+        assert nested(7) == 49
+        assert bound_changes(10) == 5
+        assert count_down(10, 0) == 30
+
+
+def test_counted_while_loop_bound_hoisted():
+    def count_up(n):
+        i = 0
+        total = 0
+        while i < n:
+            total += i
+            i += 1
+        return total
+
+    def first_square_over(n, limit):
+        i = 0
+        while i < n:
+            if i * i > limit:
+                break
+            i += 1
+        return i
+
+    # The bound is only hoisted when it was seen to fit in 64 bits, which needs OptimisticIntegers
+    level = pyjion.config()["level"]
+    pyjion.config(level=2, graph=True)
+    try:
+        for _ in range(3):
+            assert count_up(100) == 4950
+            assert first_square_over(100, 50) == 8
+        # Both loads of n, at the top and the bottom of the loop, are compiled unboxed
+        assert pyjion.graph(count_up).count("LOAD_FAST ('n')\" color=\"blue\"") == 2
+        assert pyjion.graph(first_square_over).count("LOAD_FAST ('n')\" color=\"blue\"") == 2
+        # The check at the top unboxes the bound, like other unboxed ints it raises when it doesn't fit
+        with pytest.raises(OverflowError, match="too large"):
+            first_square_over(2 ** 70, 50)
+    finally:
+        pyjion.config(level=level, graph=False)
@@ -1,3 +1,4 @@
+import math
 import statistics
 from fractions import Fraction
 import pytest
@@ -173,4 +174,129 @@ def test_strides_from_shape():
         strides = [itemsize] + list(shape[:-1])
         for i in range(1, ndim):
             strides[i] *= strides[i-1]
-    assert strides == [10, 5, 1]
\ No newline at end of file
+    assert strides == [10, 5, 1]
+
+def test_complex_arithmetic():
+    a = 1 + 2j
+    b = 3 - 1j
+    assert a + b == 4 + 1j
+    assert a - b == -2 + 3j
+    assert a * b == 5 + 5j
+    assert a / b == complex(0.1, 0.7000000000000001)
+    assert a * 2 == 2 + 4j
+    assert 2.5 - a == 1.5 - 2j
+    assert a + True == 2 + 2j
+    c = a
+    c += b * b
+    assert c == 9 - 4j
+    assert a == 1 + 2j
+    with pytest.raises(ZeroDivisionError):
+        a / 0j
+    with pytest.raises(OverflowError):
+        a * 10 ** 400
+
+
+def test_complex_temporaries():
+    a = complex(1, 2)
+    b = complex(3, -1)
+    total = 0j
+    for i in range(10):
+        total += (a * b + a) * i - b
+    assert total == 240 + 325j
+    assert a == complex(1, 2)
+    assert b == complex(3, -1)
+
+
+def test_complex_parts():
+    z = 3 + 4j
+    assert z.real == 3.0
+    assert z.imag == 4.0
+    assert (z * z).real * 2.0 + z.imag == -10.0
+    assert abs(z) == 5.0
+
+
+def test_complex_abs():
+    z = 3 + 4j
+    w = z * 2
+    assert abs(z) + 1.0 == 6.0
+    assert abs(w) * abs(z) == 50.0
+    assert abs(-z) == 5.0
+    assert abs(complex(float("inf"), float("nan"))) == float("inf")
+    big = 1.5e308 + 1.5e308j
+    with pytest.raises(OverflowError, match="absolute value too large"):
+        abs(big * 1)
+
+
+def test_math_functions():
+    x = 3.0
+    y = 4.0
+    assert math.sqrt(x * x + y * y) == 5.0
+    assert math.sqrt(16) == 4.0
+    assert math.exp(0.0) + math.log(1.0) == 1.0
+    assert math.sin(x) * math.sin(x) + math.cos(x) * math.cos(x) == pytest.approx(1.0)
+    assert math.fabs(-x) - y == -1.0
+    assert math.floor(x / 2.0) + 1 == 2
+    assert math.ceil(x / 2.0) * 2 == 4
+    assert math.floor(-x / 2.0) == -2
+    total = 0.0
+    for i in range(1, 5):
+        total += math.sqrt(i * 1.0)
+    assert total == pytest.approx(6.146264369941973)
+
+
+def test_math_function_errors():
+    x = -1.0
+    y = 1000.0
+    with pytest.raises(ValueError, match="math domain error"):
+        math.sqrt(x)
+    with pytest.raises(ValueError, match="math domain error"):
+        math.log(x + 1.0)
+    with pytest.raises(OverflowError, match="math range error"):
+        math.exp(y)
+    with pytest.raises(OverflowError):
+        math.floor(y * math.inf)
+    with pytest.raises(ValueError):
+        math.ceil(y * math.nan)
+    assert math.isnan(math.sqrt(x * math.nan))
+
+
+def test_math_floor_ceil_large():
+    def _f(x):
+        return math.floor(x * 1.0), math.ceil(-x * 1.0)
+
+    assert _f(1e20) == (10 ** 20, -10 ** 20)
+    assert _f(2.0 ** 63) == (2 ** 63, -2 ** 63)
+    assert _f(2.5) == (2, -2)
+    y = 1e20
+    assert math.floor(y + 0.0) == 100000000000000000000
+
+
+def test_math_function_patched():
+    original = math.sqrt
+    math.sqrt = lambda v: v * 2.0
+    try:
+        x = 3.0
+        assert math.sqrt(x) + 1.0 == 7.0
+    finally:
+        math.sqrt = original
+    x = 9.0
+    assert math.sqrt(x) + 1.0 == 4.0
+
+
+def test_boxed_results():
+    a = 2
+    b = 3
+    values = []
+    for i in range(-10, 300, 7):
+        values.append(i * a - b)
+    assert values == [(i * 2) - 3 for i in range(-10, 300, 7)]
+    six = 6
+    minus_five = -5
+    assert (a * b) is six
+    assert (a * b - 11) is minus_five
+    x = 1.5
+    floats = [x * i for i in range(1000)]
+    assert floats[999] == 1498.5
+    assert all(type(f) is float for f in floats)
+    assert (a > b) is False
+    assert (a < b) is True
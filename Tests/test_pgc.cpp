@@ -31,7 +31,7 @@
 
 TEST_CASE("test BINARY PGC") {
     SECTION("test simple") {
-        CHECK(g_pyjionSettings.pgc);
+        CHECK(PyJit_Settings().pgc);
         auto t = PgcProfilingTest(
                 "def f():\n  a = 1\n  b = 2.0\n  c=3\n  return a + b + c\n");
         CHECK(t.pgcStatus() == PgcStatus::Uncompiled);
@@ -0,0 +1,91 @@
+import types
+
+import pyjion
+
+
+def _fresh(f):
+    # The JIT state lives on the code object, which is shared by every run of a test
+    return types.FunctionType(f.__code__.replace(), f.__globals__, f.__name__, f.__defaults__, f.__closure__)
+
+
+def test_nojit():
+    def _f(a, b):
+        return a + b
+
+    f = pyjion.nojit(_fresh(_f))
+    for _ in range(5):
+        assert f(1, 2) == 3
+    assert not pyjion.info(f).compiled
+    assert not pyjion.compile(f)
+
+
+def test_jit_settings():
+    def _f(a, b):
+        return a * b
+
+    f = pyjion.jit(pgc=False)(_fresh(_f))
+    assert f(2, 3) == 6
+    assert pyjion.info(f).compiled
+    assert f(2, 3) == 6
+    assert pyjion.config()["pgc"]
+
+
+def test_jit_threshold():
+    def _f(a):
+        return a + 1
+
+    f = pyjion.jit(threshold=3)(_fresh(_f))
+    for _ in range(3):
+        assert f(1) == 2
+    assert not pyjion.info(f).compiled
+    assert f(1) == 2
+    assert pyjion.info(f).compiled
+
+
+def test_jit_without_arguments():
+    @pyjion.jit
+    def _f(a):
+        return a - 1
+
+    assert _f(2) == 1
+    assert pyjion.info(_f).compiled
+
+
+def test_module_policy():
+    def _f(a):
+        return a * 2
+
+    def _g(a):
+        return a * 3
+
+    pyjion.add_module_policy(__name__, enabled=False)
+    try:
+        f = _fresh(_f)
+        for _ in range(5):
+            assert f(2) == 4
+        assert not pyjion.info(f).compiled
+
+        g = pyjion.jit(_fresh(_g))
+        assert g(2) == 6
+        assert pyjion.info(g).compiled
+    finally:
+        pyjion.clear_module_policies()
+
+
+def test_jit_settings_only_while_compiling():
+    seen = []
+
+    def _f(a):
+        seen.append(pyjion.config()["level"])
+        pyjion.config(level=2)
+        return a + 1
+
+    level = pyjion.config()["level"]
+    f = pyjion.jit(level=0)(_fresh(_f))
+    try:
+        assert f(1) == 2
+        assert pyjion.info(f).compiled
+        assert seen == [level]
+        assert pyjion.config()["level"] == 2
+    finally:
+        pyjion.config(level=level)
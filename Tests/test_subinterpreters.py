@@ -0,0 +1,81 @@
+import textwrap
+
+import pytest
+import pyjion
+
+_interpreters = pytest.importorskip("_xxsubinterpreters")
+
+
+def test_jit_in_subinterpreter():
+    level = pyjion.config()["level"]
+    interp = _interpreters.create()
+    try:
+        _interpreters.run_string(interp, textwrap.dedent("""
+            import pyjion
+
+            def f(a, b):
+                return a + b
+
+            pyjion.enable()
+            pyjion.config(level=0)
+            for _ in range(5):
+                assert f(1, 2) == 3
+            pyjion.disable()
+            assert pyjion.info(f).compiled
+            assert pyjion.stats()["compiled"] >= 1
+        """))
+    finally:
+        _interpreters.destroy(interp)
+    # Settings are per interpreter
+    assert pyjion.config()["level"] == level
+
+
+def test_jit_in_subinterpreters_after_destroy():
+    for _ in range(3):
+        interp = _interpreters.create()
+        try:
+            _interpreters.run_string(interp, textwrap.dedent("""
+                import pyjion
+
+                def f(a):
+                    return a * 2
+
+                pyjion.enable()
+                for _ in range(5):
+                    assert f(2) == 4
+                pyjion.disable()
+                assert pyjion.info(f).compiled
+            """))
+        finally:
+            _interpreters.destroy(interp)
+
+
+def test_boxing_in_subinterpreter():
+    interp = _interpreters.create()
+    try:
+        _interpreters.run_string(interp, textwrap.dedent("""
+            import pyjion
+
+            def f(a, b):
+                return a + b, a * 0.5, sum(i for i in range(a))
+
+            pyjion.enable()
+            for _ in range(5):
+                assert f(3, 4) == (7, 1.5, 3)
+            pyjion.disable()
+            assert pyjion.info(f).compiled
+            # The boxed small ints are this interpreter's own
+            x, y, total = f(3, 4)
+            assert x is int("7")
+            assert total is int("3")
+        """))
+    finally:
+        _interpreters.destroy(interp)
+
+    # The main interpreter's jitted code still boxes into its own objects
+    def g(a, b):
+        return a + b, a * 0.5
+
+    for _ in range(5):
+        assert g(3, 4) == (7, 1.5)
+    assert g(3, 4)[0] is int("7")
@@ -3,6 +3,7 @@ import pyjion
 import io
 import dis
 import sys
+import types
 import pytest
 
 
@@ -125,3 +126,58 @@ def test_custom_tracer(capsys):
     captured = capsys.readouterr()
     assert "Calling <code object _f" in captured.out
     assert "Returning " in captured.out
+
+
+def test_settrace_after_compile():
+    def _g(a, b):
+        return a + b
+
+    # The JIT state lives on the code object, which is shared by every run of a test
+    _f = types.FunctionType(_g.__code__.replace(), _g.__globals__)
+    for _ in range(5):
+        assert _f(1, 2) == 3
+    info = pyjion.info(_f)
+    assert info.compiled
+    assert not info.tracing
+
+    events = []
+
+    def tracer(frame, event, arg):
+        if frame.f_code is _f.__code__:
+            events.append(event)
+        return tracer
+
+    sys.settrace(tracer)
+    try:
+        assert _f(1, 2) == 3
+    finally:
+        sys.settrace(None)
+    assert "call" in events
+    assert "return" in events
+    assert pyjion.info(_f).tracing
+
+    # Detaching the tracer goes back to the untraced variant
+    events.clear()
+    assert _f(2, 2) == 4
+    assert events == []
+
+
+def test_setprofile_after_compile():
+    def _f(a, b):
+        return a * b
+
+    for _ in range(5):
+        assert _f(2, 3) == 6
+
+    events = []
+
+    def profiler(frame, event, arg):
+        if frame.f_code is _f.__code__:
+            events.append(event)
+
+    sys.setprofile(profiler)
+    try:
+        assert _f(2, 3) == 6
+    finally:
+        sys.setprofile(None)
+    assert events == ["call", "return"]
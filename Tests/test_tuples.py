@@ -90,3 +90,13 @@ def test_tuple_unpacking():
     assert t == (1, 2, 3)
     t = (*"he", "l", *"lo")
     assert t == ("h", "e", "l", "l", "o")
+
+
+def test_multiple_assignment_refcount():
+    a, b, c, d = str(1), str(2), str(3), str(4)
+    r = sys.getrefcount(a)
+    for _ in range(3):
+        a, b, c, d = d, c, b, a
+        a, b = b, a
+    assert (a, b, c, d) == ('4', '3', '1', '2')
+    assert sys.getrefcount(c) == r
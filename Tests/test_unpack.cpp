@@ -131,6 +131,64 @@ TEST_CASE("Test unpacking with UNPACK_SEQUENCE") {
     }
 }
 
+TEST_CASE("Test swaps and multiple assignment") {
+    SECTION("test swap") {
+        auto t = EmissionTest(
+                "def f():\n  a, b = 1, 2\n  a, b = b, a\n  return a, b");
+        CHECK(t.returns() == "(2, 1)");
+    }
+
+    SECTION("test unboxed fibonacci") {
+        auto t = EmissionTest(
+                "def f():\n"
+                "  a, b = 0, 1\n"
+                "  for _ in range(50):\n"
+                "    a, b = b, a + b\n"
+                "  return a, b");
+        CHECK(t.returns() == "(12586269025, 20365011074)");
+    }
+
+    SECTION("test mixed int and float rotation") {
+        auto t = EmissionTest(
+                "def f():\n"
+                "  a, b, c = 1, 2.5, 3\n"
+                "  for _ in range(4):\n"
+                "    a, b, c = c, a + 1, b * 2.0\n"
+                "  return a, b, c");
+        CHECK(t.returns() == "(8.0, 5.0, 12.0)");
+    }
+
+    SECTION("test four way reversal") {
+        auto t = EmissionTest(
+                "def f():\n"
+                "  a, b, c, d = 1, 2.0, 'c', [4]\n"
+                "  a, b, c, d = d, c, b, a\n"
+                "  return a, b, c, d");
+        CHECK(t.returns() == "([4], 'c', 2.0, 1)");
+    }
+
+    SECTION("test unboxed five way rotation") {
+        auto t = EmissionTest(
+                "def f():\n"
+                "  a, b, c, d, e = 1, 2, 3, 4, 5\n"
+                "  for _ in range(3):\n"
+                "    a, b, c, d, e = b, c, d, e, a + e\n"
+                "  return a, b, c, d, e");
+        CHECK(t.returns() == "(4, 5, 6, 8, 11)");
+    }
+
+    SECTION("test unpack of a tuple from either branch") {
+        auto t = EmissionTest(
+                "def f():\n"
+                "  r = []\n"
+                "  for x in (0, 1):\n"
+                "    a, b, c, d = (1, 2, 3, 4) if x else (x, x, x, x)\n"
+                "    r.append((a, b, c, d))\n"
+                "  return r");
+        CHECK(t.returns() == "[(0, 0, 0, 0), (1, 2, 3, 4)]");
+    }
+}
+
 TEST_CASE("Test unpacking with UNPACK_EX") {
     SECTION("basic unpack from range iterator, return left") {
         auto t = EmissionTest(
@@ -2,6 +2,7 @@ import ctypes
 import pathlib
 import os
 import platform
+import types
 from enum import IntFlag, IntEnum
 from dataclasses import dataclass
 
@@ -74,8 +75,9 @@ def _which_dotnet() -> str:
 lib_path = _which_dotnet()
 
 try:
-    from ._pyjion import enable, disable, info as _info, il, native, offsets, \
-        graph, init as _init, symbols, config, PyjionUnboxingError
+    from ._pyjion import enable, disable, freeze, stats, info as _info, il, native, offsets, \
+        graph, init as _init, symbols, config, compile as _compile, compile_batch as _compile_batch, \
+        set_policy as _set_policy, add_module_policy as _add_module_policy, clear_module_policies, PyjionUnboxingError
 
     _init(lib_path)
 except ImportError:
@@ -138,6 +140,8 @@ class JitInfo:
     run_count: int
     tracing: bool
     profiling: bool
+    consumer: bool
+    direct: bool
 
 
 def info(f) -> JitInfo:
@@ -149,4 +153,96 @@ def info(f) -> JitInfo:
                    PgcStatus(d['pgc']),
                    d['run_count'],
                    d['tracing'],
-                   d['profiling'])
+                   d['profiling'],
+                   d['consumer'],
+                   d['direct'])
+
+
+def compile(f, arg_types=None) -> bool:
+    """
+    Compile a function now instead of on its first call(s).
+
+    ``arg_types`` is a sequence (or a dict of argument name to type) of the argument types to specialize for,
+    ``None`` leaves an argument unspecialized. Returns ``True`` if the function was compiled, nothing is compiled
+    after ``freeze()``.
+    """
+    if isinstance(f, (staticmethod, classmethod)):
+        f = f.__func__
+    if isinstance(arg_types, dict):
+        code = f.__code__
+        names = code.co_varnames[:code.co_argcount + code.co_kwonlyargcount]
+        arg_types = [arg_types.get(name) for name in names]
+    return _compile(f, arg_types)
+
+
+def _nested_code(code):
+    for const in code.co_consts:
+        if isinstance(const, types.CodeType):
+            yield const
+            yield from _nested_code(const)
+
+
+def compile_module(mod, recursive=True, workers=1) -> dict:
+    """
+    Compile every function defined in a module.
+
+    With ``recursive``, methods of classes defined in the module and nested functions are compiled too.
+    With ``workers`` greater than 1 the native compilation runs on that many threads, ``0`` uses one per CPU.
+    Returns a dictionary of qualified name to whether it compiled.
+    """
+    names = []
+    items = []
+    globals_ = mod.__dict__
+    pending = list(globals_.values())
+    seen = set()
+    while pending:
+        obj = pending.pop()
+        if id(obj) in seen:
+            continue
+        seen.add(id(obj))
+        if isinstance(obj, (staticmethod, classmethod)):
+            obj = obj.__func__
+        if isinstance(obj, types.FunctionType) and obj.__module__ == mod.__name__:
+            names.append(obj.__qualname__)
+            items.append((obj,))
+            if recursive:
+                for code in _nested_code(obj.__code__):
+                    names.append(f"{obj.__qualname__}.{code.co_name}")
+                    items.append((code, None, obj.__globals__))
+        elif recursive and isinstance(obj, type) and obj.__module__ == mod.__name__:
+            pending.extend(obj.__dict__.values())
+    return dict(zip(names, _compile_batch(items, workers)))
+
+
+def jit(f=None, *, level=None, pgc=None, threshold=None):
+    """
+    Decorator to compile a function with its own settings, in place of the ones set with ``config()``.
+
+    ``level``, ``pgc`` and ``threshold`` override the optimization level, profile-guided compilation and the
+    number of calls before it is compiled. ``None`` keeps the setting. Can be used with or without arguments.
+    """
+    def decorator(func):
+        target = func.__func__ if isinstance(func, (staticmethod, classmethod)) else func
+        _set_policy(target, True, level, pgc, threshold)
+        return func
+    if f is None:
+        return decorator
+    return decorator(f)
+
+
+def nojit(f):
+    """
+    Decorator to never compile a function, it always runs in the CPython interpreter.
+    """
+    target = f.__func__ if isinstance(f, (staticmethod, classmethod)) else f
+    _set_policy(target, False)
+    return f
+
+
+def add_module_policy(pattern, *, enabled=True, level=None, pgc=None, threshold=None) -> None:
+    """
+    Set whether, and with which settings, functions in modules whose name matches ``pattern`` (an ``fnmatch``
+    pattern, e.g. ``"tests.*"``) are compiled. The first policy matching a module applies, and policies on functions
+    (``@jit``, ``@nojit``) take precedence.
+    """
+    _add_module_policy(pattern, enabled, level, pgc, threshold)
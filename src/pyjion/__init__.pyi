@@ -1,11 +1,12 @@
-from typing import Dict, Any, Callable, Optional
+from types import ModuleType
+from typing import Dict, Any, Callable, Optional, Sequence, Union
 
 from pyjion import JitInfo
 
 
 def enable() -> bool:
     """
-    Enable the JIT.
+    Enable the JIT for the current interpreter.
     
     :returns: ``True`` on success, ``False`` on failure.
     """
@@ -13,12 +14,28 @@ def enable() -> bool:
 
 def disable() -> bool:
     """
-    Disable the JIT.
+    Disable the JIT for the current interpreter.
     
     :returns: ``True`` on success, ``False`` on failure.
     """
     ...
 
+def freeze() -> bool:
+    """
+    Stop compiling, make the compiled machine code read-only and stop updating the JIT state of functions on each
+    call, so processes forked afterwards share the compiled code copy-on-write.
+
+    :returns: ``True`` if the JIT was frozen, ``False`` if it was already frozen.
+    """
+    ...
+
+def stats() -> Dict[str, int]:
+    """
+    Get the number of functions compiled (and failed) by the current interpreter, the size of their IL and machine
+    code, and the size of the code heap shared by all interpreters.
+    """
+    ...
+
 def info(f: Callable) -> JitInfo:
     """
     Pyjion JIT information on a compiled function.
@@ -43,6 +60,32 @@ def info(f: Callable) -> JitInfo:
 def config(pgc: Optional[bool], level: Optional[int], debug: Optional[bool], graph: Optional[bool], threshold: Optional[int], ) -> Dict[str, Any]:
     ...
 
+def compile(f: Callable, arg_types: Optional[Union[Sequence[Optional[type]], Dict[str, type]]] = None) -> bool:
+    """
+    Compile a function now instead of waiting for its first call(s).
+
+    >>> def f(a, b):
+            return a * b
+    >>> pyjion.compile(f, arg_types=(float, float))
+    True
+
+    :param f: The function to compile
+    :param arg_types: The types of the arguments to specialize for, as a sequence or a dict of name to type
+    :returns: ``True`` if the function compiled
+    """
+    ...
+
+def compile_module(mod: ModuleType, recursive: bool = True, workers: int = 1) -> Dict[str, bool]:
+    """
+    Compile all functions defined in a module.
+
+    :param mod: The module
+    :param recursive: Also compile methods of classes and nested functions
+    :param workers: Number of threads to run the native compilation on, 0 for one per CPU
+    :returns: A dictionary of qualified names and whether they compiled
+    """
+    ...
+
 def offsets(f: Callable) -> tuple[tuple[int, int, int, int]]:
     ...
 
@@ -58,6 +101,47 @@ def il(f: Callable) -> bytearray:
 def native(f: Callable) -> tuple[bytearray, int, int]:
     ...
 
+def jit(f: Optional[Callable] = None, *, level: Optional[int] = None, pgc: Optional[bool] = None, threshold: Optional[int] = None) -> Callable:
+    """
+    Decorator to compile a function with its own settings instead of the ones set with ``config()``.
+
+    >>> @pyjion.jit(level=2, pgc=False)
+        def kernel(x, y):
+            return x * y + 1.0
+
+    :param level: Optimization level for this function
+    :param pgc: Enable or disable profile-guided compilation for this function
+    :param threshold: Number of calls before the function is compiled
+    """
+    ...
+
+def nojit(f: Callable) -> Callable:
+    """
+    Decorator to never compile a function.
+    """
+    ...
+
+def add_module_policy(pattern: str, *, enabled: bool = True, level: Optional[int] = None, pgc: Optional[bool] = None, threshold: Optional[int] = None) -> None:
+    """
+    Set whether, and with which settings, functions in modules matching a pattern are compiled.
+
+    >>> pyjion.add_module_policy("tests.*", enabled=False)
+    >>> pyjion.add_module_policy("ourpkg.kernels.*", level=2)
+
+    :param pattern: ``fnmatch`` style pattern of module names, the first matching policy applies
+    :param enabled: Compile the functions in matching modules
+    :param level: Optimization level for matching modules
+    :param pgc: Enable or disable profile-guided compilation for matching modules
+    :param threshold: Number of calls before functions in matching modules are compiled
+    """
+    ...
+
+def clear_module_policies() -> None:
+    """
+    Remove all the module policies.
+    """
+    ...
+
 class PyjionUnboxingError(ValueError):
     ...
 
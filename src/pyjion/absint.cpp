@@ -36,7 +36,7 @@
 #include "pycomp.h"
 #include "attrtable.h"
 
-#define PGC_READY() g_pyjionSettings.pgc&& profile != nullptr
+#define PGC_READY() PyJit_Settings().pgc&& profile != nullptr
 
 #define PGC_PROBE(count) \
     pgcRequired = true;  \
@@ -68,6 +68,8 @@ AbstractInterpreter::AbstractInterpreter(PyCodeObject* code, IPythonCompiler* co
     mSize = PyBytes_Size(code->co_code);
     mTracingEnabled = false;
     mProfilingEnabled = false;
+    mConsumerEnabled = false;
+    mDirectVariantEnabled = false;
 
     if (comp != nullptr) {
         m_retLabel = comp->emit_define_label();
@@ -95,7 +97,7 @@ AbstractInterpreterResult AbstractInterpreter::preprocess() {
         // all parameters are initially definitely assigned
         m_assignmentState[i] = true;
     }
-    if (mSize >= g_pyjionSettings.codeObjectSizeLimit) {
+    if (mSize >= PyJit_Settings().codeObjectSizeLimit) {
         return IncompatibleSize;
     }
 
@@ -124,7 +126,7 @@ AbstractInterpreterResult AbstractInterpreter::preprocess() {
 
             // Opcodes that push basic blocks
             case SETUP_FINALLY:
-                if (!g_pyjionSettings.exceptionHandling)
+                if (!PyJit_Settings().exceptionHandling)
                     return IncompatibleOpcode_WithExcept;
             case SETUP_WITH:
             case SETUP_ASYNC_WITH:
@@ -202,6 +204,16 @@ void AbstractInterpreter::setLocalType(size_t index, PyObject* val) {
     }
 }
 
+void AbstractInterpreter::setLocalType(size_t index, PyTypeObject* type) {
+    auto& lastState = mStartStates[0];
+    if (type != nullptr) {
+        // Without a value to check the size of, a declared int stays a big integer so any int can be passed.
+        auto localInfo = AbstractLocalInfo(new PgcValue(type, GetAbstractType(type)));
+        localInfo.ValueInfo.Sources = newSource(new LocalSource(index));
+        lastState.replaceLocal(index, localInfo);
+    }
+}
+
 void AbstractInterpreter::initStartingState() {
     InterpreterState lastState = InterpreterState(mCode->co_nlocals);
 
@@ -565,9 +577,16 @@ AbstractInterpreter::interpret(PyObject* builtins, PyObject* globals, PyjionCode
                         PGC_UPDATE_STACK(1);
                     }
                     auto obj = POP_VALUE();
-                    if (OPT_ENABLED(AttrTypeTable)){
+                    if (obj.hasValue() && obj.Value->kind() == AVK_Complex &&
+                        (!strcmp(utf8_names[oparg], "real") || !strcmp(utf8_names[oparg], "imag"))) {
+                        if (obj.Value->needsGuard()) {
+                            PUSH_INTERMEDIATE(new PgcValue(&PyFloat_Type, AVK_Float));
+                        } else {
+                            PUSH_INTERMEDIATE(&Float);
+                        }
+                    } else if (OPT_ENABLED(AttrTypeTable)){
                         if (obj.hasValue() && obj.Value->known()) {
-                            auto avk = g_attrTable->getAttr(obj.Value->pythonType(), utf8_names[oparg]);
+                            auto avk = PyJit_InterpreterState()->attrTable.getAttr(obj.Value->pythonType(), utf8_names[oparg]);
                             if (avk == AVK_Any){
                                 PUSH_INTERMEDIATE(&Any);
                             } else {
@@ -588,7 +607,7 @@ AbstractInterpreter::interpret(PyObject* builtins, PyObject* globals, PyjionCode
                     auto value = POP_VALUE();
                     if (OPT_ENABLED(AttrTypeTable)){
                         if (obj.hasValue() && obj.Value->known() && value.hasValue() && value.Value->known()) {
-                            if (g_attrTable->captureStoreAttr(obj.Value->pythonType(), utf8_names[oparg], value.Value->kind()) != 0){
+                            if (PyJit_InterpreterState()->attrTable.captureStoreAttr(obj.Value->pythonType(), utf8_names[oparg], value.Value->kind()) != 0){
 #ifdef DEBUG_VERBOSE
                                 printf("!Switching value of %s.%s to %u at %s:%d\n", obj.Value->pythonType()->tp_name, utf8_names[oparg], value.Value->kind(), PyUnicode_AsUTF8(mCode->co_name), curByte);
 #endif
@@ -608,6 +627,20 @@ AbstractInterpreter::interpret(PyObject* builtins, PyObject* globals, PyjionCode
                     break;
                 }
                 case BUILD_TUPLE: {
+                    if (buildsUnpackedTuple(opcodeIndex)) {
+                        // Reverse the values in place of building and unpacking the tuple
+                        vector<AbstractValueWithSources> values;
+                        for (int i = 0; i < oparg; i++) {
+                            auto value = POP_VALUE();
+                            values.push_back(value);
+                        }
+                        for (auto& value : values) {
+                            value.Sources = newSource(new IntermediateSource(curByte));
+                            lastState.push(value);
+                        }
+                        skipEffect = true;
+                        break;
+                    }
                     for (int i = 0; i < oparg; i++) {
                         POP_VALUE();
                     }
@@ -650,8 +683,13 @@ AbstractInterpreter::interpret(PyObject* builtins, PyObject* globals, PyjionCode
                     }
                     int argCnt = oparg & 0xff;
                     int kwArgCnt = (oparg >> 8) & 0xff;
+                    vector<AbstractValueKind> argKinds(argCnt);
+                    AbstractSource* lastArgSource = nullptr;
                     for (int i = 0; i < argCnt; i++) {
-                        POP_VALUE();
+                        auto arg = POP_VALUE();
+                        argKinds[argCnt - 1 - i] = arg.hasValue() ? arg.Value->kind() : AVK_Any;
+                        if (i == 0)
+                            lastArgSource = arg.Sources;
                     }
                     for (int i = 0; i < kwArgCnt; i++) {
                         POP_VALUE();
@@ -660,6 +698,18 @@ AbstractInterpreter::interpret(PyObject* builtins, PyObject* globals, PyjionCode
 
                     // pop the function...
                     auto func = POP_VALUE();
+                    auto builtin = inlineBuiltin(func.Sources, argKinds, argCnt == 2 ? lastArgSource : nullptr);
+                    if (inlineBuiltinUnboxesArgs(builtin) && !inlineBuiltinBoxesResult(builtin)) {
+                        // abs(), min(), max() and conversions of ints or floats, which is guarded as the arguments could change type
+                        auto kind = inlineBuiltinKind(builtin, argKinds);
+                        PUSH_INTERMEDIATE(new PgcValue(GetPyType(kind), kind));
+                        break;
+                    }
+                    if (builtin == InlineAbsComplex) {
+                        // Guarded as above, the argument is checked to still be a complex
+                        PUSH_INTERMEDIATE(new PgcValue(&PyFloat_Type, AVK_Float));
+                        break;
+                    }
                     auto source = AbstractValueWithSources(
                             avkToAbstractValue(knownFunctionReturnType(func)),
                             newSource(new LocalSource(curByte)));
@@ -749,11 +799,21 @@ AbstractInterpreter::interpret(PyObject* builtins, PyObject* globals, PyjionCode
                     break;
                 }
                 case UNPACK_SEQUENCE: {
+                    if (opcodeIndex >= SIZEOF_CODEUNIT && buildsUnpackedTuple(opcodeIndex - SIZEOF_CODEUNIT)) {
+                        skipEffect = true;
+                        break;
+                    }
                     if (PGC_READY()) {
                         PGC_PROBE(1);
                         PGC_UPDATE_STACK(1);
                     }
                     auto container = POP_VALUE();
+                    if (enumerateStep(opcodeIndex)) {
+                        // The counter is pushed last, on top of the item
+                        PUSH_INTERMEDIATE(container.Value->item(container.Sources));
+                        PUSH_INTERMEDIATE(&Integer);
+                        break;
+                    }
                     for (int i = 0; i < oparg; i++) {
                         PUSH_INTERMEDIATE(container.Value->item(container.Sources));
                     }
@@ -921,13 +981,28 @@ AbstractInterpreter::interpret(PyObject* builtins, PyObject* globals, PyjionCode
                         PGC_PROBE(1 + oparg);
                         PGC_UPDATE_STACK(1 + oparg);
                     }
+                    AbstractValueKind argKind = AVK_Any;
                     for (int i = 0; i < oparg; i++) {
-                        POP_VALUE();
+                        auto arg = POP_VALUE();
+                        if (arg.hasValue())
+                            argKind = arg.Value->kind();
                     }
                     auto method = POP_VALUE();
                     auto self = POP_VALUE();
 
-                    if (method.hasValue() && method.Value->kind() == AVK_Method && self.Value->known()) {
+                    const NativeMathFunction* mathFunction = nullptr;
+                    if (oparg == 1 && dynamic_cast<MethodSource*>(method.Sources) != nullptr && dynamic_cast<GlobalValue*>(self.Value) != nullptr) {
+                        mathFunction = nativeMathFunction(dynamic_cast<GlobalValue*>(self.Value)->lastValue(), dynamic_cast<MethodSource*>(method.Sources)->name(), argKind);
+                    }
+                    if (mathFunction != nullptr) {
+                        // Guarded at runtime, anything else than the builtin has its result unboxed with a type check.
+                        // floor() and ceil() return int objects, which can be big ints.
+                        if (mathFunction->returnsInt) {
+                            PUSH_INTERMEDIATE(new PgcValue(&PyLong_Type, AVK_Integer));
+                        } else {
+                            PUSH_INTERMEDIATE(new PgcValue(&PyFloat_Type, AVK_Float));
+                        }
+                    } else if (method.hasValue() && method.Value->kind() == AVK_Method && self.Value->known()) {
                         auto meth_source = dynamic_cast<MethodSource*>(method.Sources);
                         lastState.push(AbstractValueWithSources(avkToAbstractValue(avkToAbstractValue(self.Value->kind())->resolveMethod(meth_source->name())),
                                                                 newSource(new IntermediateSource(curByte))));
@@ -1611,6 +1686,46 @@ void AbstractInterpreter::yieldValue(py_opindex index, size_t stackSize, Instruc
     m_comp->emit_dec_frame_stackdepth(stackSize);
 }
 
+void AbstractInterpreter::consumeValue(py_opindex index) {
+    // The consumer variant never suspends, the value goes straight to the consumer and the generator carries on
+    m_comp->emit_lasti_update(index);
+    m_comp->emit_consume_value();
+    decStack();
+
+    auto status = m_comp->emit_define_local(LK_Int);
+    auto noErr = m_comp->emit_define_label(), resume = m_comp->emit_define_label();
+    m_comp->emit_store_local(status);
+    m_comp->emit_load_local(status);
+    m_comp->emit_int(-1);
+    m_comp->emit_branch(BranchNotEqual, noErr);
+    branchRaise("consumer failed", "", index);
+    m_comp->emit_mark_label(noErr);
+    m_comp->emit_load_and_free_local(status);
+    m_comp->emit_branch(BranchFalse, resume);
+
+    // The consumer has its result (any() or all()), clear the stack and return as if the generator was exhausted
+    for (auto cur = m_stack.rbegin(); cur != m_stack.rend(); cur++) {
+        if (*cur == STACK_KIND_OBJECT)
+            m_comp->emit_pop_top();
+        else
+            m_comp->emit_pop();
+    }
+    m_comp->emit_ptr(Py_None);
+    m_comp->emit_dup();
+    m_comp->emit_incref();
+    m_comp->emit_store_local(m_retValue);
+    m_comp->emit_set_frame_state(PY_FRAME_RETURNED);
+    m_comp->emit_set_frame_stackdepth(0);
+    m_comp->emit_branch(BranchAlways, m_retLabel);
+
+    // Resume with None, as if next() sent it
+    m_comp->emit_mark_label(resume);
+    m_comp->emit_ptr(Py_None);
+    m_comp->emit_dup();
+    m_comp->emit_incref();
+    incStack();
+}
+
 AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc_status, InstructionGraph* graph) {// NOLINT(readability-function-cognitive-complexity)
     Label ok;
     OptimizationFlags optimizationsMade = OptimizationFlags();
@@ -1630,10 +1745,16 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
         for (auto& fastLocal : graph->getUnboxedFastLocals()) {
             m_fastNativeLocals[fastLocal.first] = m_comp->emit_define_local(fastLocal.second);
             m_fastNativeLocalKinds[fastLocal.first] = avkAsStackEntryKind(fastLocal.second);
+            // Unboxed arguments of the direct variant are passed in its PyjionDirectCall
+            if (fastLocal.first < mCode->co_argcount) {
+                m_comp->emit_load_direct_arg(fastLocal.first, fastLocal.second);
+                m_comp->emit_store_local(m_fastNativeLocals[fastLocal.first]);
+                mDirectArgKinds[fastLocal.first] = fastLocal.second;
+            }
         }
     }
 
-    if (mCode->co_flags & CO_GENERATOR) {
+    if (suspends()) {
         yieldJumps();
     }
 
@@ -1705,7 +1826,7 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
         bool skipEffect = false;
 
         auto edges = graph->getEdges(curByte);
-        if (g_pyjionSettings.pgc && pgcProbeRequired(curByte, pgc_status) && !(CAN_UNBOX() && op.escape)) {
+        if (PyJit_Settings().pgc && pgcProbeRequired(curByte, pgc_status) && !(CAN_UNBOX() && op.escape)) {
             emitPgcProbes(curByte, pgcProbeSize(curByte), edges);
         }
 
@@ -1719,15 +1840,27 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 // EXTENDED_ARG is precalculated in the graph loop
                 break;
             case ROT_TWO: {
-                m_comp->emit_rot_two();
+                if (CAN_UNBOX() && op.escape) {
+                    reorderStack({0, 1}, edges);
+                } else {
+                    m_comp->emit_rot_two();
+                }
                 break;
             }
             case ROT_THREE: {
-                m_comp->emit_rot_three();
+                if (CAN_UNBOX() && op.escape) {
+                    reorderStack({0, 2, 1}, edges);
+                } else {
+                    m_comp->emit_rot_three();
+                }
                 break;
             }
             case ROT_FOUR: {
-                m_comp->emit_rot_four();
+                if (CAN_UNBOX() && op.escape) {
+                    reorderStack({0, 3, 2, 1}, edges);
+                } else {
+                    m_comp->emit_rot_four();
+                }
                 break;
             }
             case POP_TOP:
@@ -1881,14 +2014,29 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 m_assignmentState[oparg] = true;
                 break;
             case LOAD_FAST:
-                if (CAN_UNBOX() && op.escape) {
+                if (CAN_UNBOX() && op.escape && graph->isLoopBound(op.index)) {
+                    loadLoopBound(oparg, graph->getLoopBoundEntry(op.index), opcodeIndex);
+                } else if (CAN_UNBOX() && op.escape) {
                     loadFastUnboxed(oparg, opcodeIndex);
                 } else {
                     loadFast(oparg, opcodeIndex);
                 }
                 break;
             case UNPACK_SEQUENCE:
-                m_comp->emit_unpack_sequence(oparg, stackInfo.top());
+                if (curByte >= SIZEOF_CODEUNIT && buildsUnpackedTuple(curByte - SIZEOF_CODEUNIT)) {
+                    // Values were already reversed by BUILD_TUPLE
+                    skipEffect = true;
+                    break;
+                }
+                if (CAN_UNBOX() && op.escape) {
+                    unpackEnumerate(m_unpackSteps.find(curByte) != m_unpackSteps.end(), stackInfo.top(), op.index);
+                    break;
+                }
+                if (m_unpackSteps.find(curByte) != m_unpackSteps.end()) {
+                    m_comp->emit_unpack_iter(oparg, stackInfo.top());
+                } else {
+                    m_comp->emit_unpack_sequence(oparg, stackInfo.top());
+                }
                 decStack();
                 incStack(oparg);
                 intErrorCheck("failed to unpack sequence", stackInfo.top().Value->describe());
@@ -1929,7 +2077,31 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 incStack();
                 break;
             case CALL_FUNCTION: {
-                if (OPT_ENABLED(FunctionCalls) &&
+                if (CAN_UNBOX() && op.escape) {
+                    if (graph->getDirectCallKind(op.index) != AVK_Any)
+                        directCall(graph->getDirectCallKind(op.index), graph->getDirectCallArgKinds(op.index), oparg, op.index);
+                    else
+                        inlineBuiltinCall(graph->getInlineBuiltin(op.index), edges, oparg, op.index);
+                    break;
+                }
+                auto unpackWidth = unpackLoopWidth(curByte, oparg, stackInfo);
+                auto consumer = generatorConsumer(curByte, oparg, stackInfo);
+                if (consumer != -1) {
+                    FLAG_OPT_USAGE(InlineIterators);
+                    m_comp->emit_consume_generator(consumer);
+                    decStack(2);// target + generator
+                    errorCheck("consume generator failed", "", op.index);
+                } else if (unpackWidth != 0) {
+                    FLAG_OPT_USAGE(InlineIterators);
+                    buildTuple(oparg);
+                    incStack();
+                    // The counter of an enumerate() loop is never boxed when the loop unpacks it unboxed
+                    m_comp->emit_unpack_iter_new(unpackWidth, CAN_UNBOX() && (*graph)[curByte + 3 * SIZEOF_CODEUNIT].escape);
+                    decStack(2);// target + args
+                    errorCheck("call function failed", "", op.index);
+                    m_unpackLoops.insert(curByte + 2 * SIZEOF_CODEUNIT);
+                    m_unpackSteps.insert(curByte + 3 * SIZEOF_CODEUNIT);
+                } else if (OPT_ENABLED(FunctionCalls) &&
                     stackInfo.size() >= (oparg + 1) &&
                     stackInfo.nth(oparg + 1).hasSource() &&
                     stackInfo.nth(oparg + 1).hasValue() && !mTracingEnabled) {
@@ -1953,15 +2125,35 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 break;
             }
             case BUILD_TUPLE:
+                if (buildsUnpackedTuple(curByte)) {
+                    vector<size_t> order;
+                    for (size_t i = 0; i < oparg; i++) {
+                        order.push_back(i);
+                    }
+                    reorderStack(order, CAN_UNBOX() && op.escape ? edges : vector<Edge>());
+                    skipEffect = true;
+                    break;
+                }
                 buildTuple(oparg);
                 incStack();
                 break;
             case BUILD_LIST:
-                buildList(oparg);
+                if (oparg == 0 && startsComprehension(curByte)) {
+                    m_comp->emit_new_comprehension_list();
+                    errorCheck("build list failed", "", op.index);
+                    m_trimListOnReturn = true;
+                } else {
+                    buildList(oparg);
+                }
                 incStack();
                 break;
             case BUILD_MAP:
-                buildMap(oparg);
+                if (oparg == 0 && startsComprehension(curByte)) {
+                    m_comp->emit_new_comprehension_dict();
+                    errorCheck("build map failed", "", op.index);
+                } else {
+                    buildMap(oparg);
+                }
                 incStack();
                 break;
             case STORE_SUBSCR:
@@ -2037,7 +2229,12 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 }
                 break;
             case BINARY_SUBSCR:
-                if (CAN_UNBOX() && op.escape) {
+                if (CAN_UNBOX() && op.escape && graph->isListIndex(op.index)) {
+                    m_comp->emit_list_index(graph->isInBoundsIndex(op.index) ? m_rangeListGuards[graph->getInBoundsLoop(op.index)] : Local());
+                    decStack(2);
+                    errorCheck("list index failed", "", op.index);
+                    incStack();
+                } else if (CAN_UNBOX() && op.escape) {
                     auto retKind = m_comp->emit_unboxed_binary_subscr(stackInfo.second(), stackInfo.top());
                     decStack(2);
                     invalidIntErrorCheck("unboxed binary op failed", op.index, byte, PyExc_IndexError, "bytearray index out of range");
@@ -2112,6 +2309,12 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 }
                 break;
             case RETURN_VALUE:
+                if (CAN_UNBOX() && op.escape) {
+                    unboxedReturnValue(edges[0].kind, opcodeIndex);
+                    break;
+                }
+                if (m_trimListOnReturn)
+                    m_comp->emit_trim_list();
                 returnValue(opcodeIndex);
                 break;
             case MAKE_FUNCTION:
@@ -2135,8 +2338,28 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 incStack();
                 break;
             case GET_ITER: {
+                auto dictWidth = dictLoopWidth(curByte, stackInfo);
                 if (CAN_UNBOX() && op.escape) {
+                    if (graph->isRangeListLoop(op.index)) {
+                        m_rangeListGuards[op.index] = m_comp->emit_define_local(LK_Int);
+                        m_comp->emit_range_indexes_lists(graph->getRangeListLoopLists(op.index), m_rangeListGuards[op.index]);
+                    }
                     m_comp->emit_getiter_unboxed();
+                } else if (dictWidth != 0) {
+                    FLAG_OPT_USAGE(InlineIterators);
+                    m_comp->emit_getiter_unpack(dictWidth);
+                    m_unpackLoops.insert(curByte + SIZEOF_CODEUNIT);
+                    if (dictWidth > 1)
+                        m_unpackSteps.insert(curByte + 2 * SIZEOF_CODEUNIT);
+                } else if (OPT_ENABLED(InlineIterators) && !suspends() &&
+                           curByte + SIZEOF_CODEUNIT < mSize && GET_OPCODE(curByte + SIZEOF_CODEUNIT) == FOR_ITER &&
+                           !stackInfo.empty() && stackInfo.top().hasValue() && stackInfo.top().Value->known() &&
+                           (stackInfo.top().Value->kind() == AVK_List || stackInfo.top().Value->kind() == AVK_Tuple)) {
+                    // The loop index lives in IL locals, which don't survive a yield, so suspending generators keep the iterator
+                    FLAG_OPT_USAGE(InlineIterators);
+                    SequenceLoop loop = {m_comp->emit_define_local(LK_NativeInt), m_comp->emit_define_local(LK_NativeInt), stackInfo.top()};
+                    m_sequenceLoops[curByte + SIZEOF_CODEUNIT] = loop;
+                    m_comp->emit_getiter_sequence(loop.index, loop.size, loop.iterable);
                 } else {
                     m_comp->emit_getiter();
                 }
@@ -2148,8 +2371,13 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
             case FOR_ITER: {
                 auto postIterStack = ValueStack(m_stack);
                 postIterStack.dec(1);// pop iter when stopiter happens
+                auto sequenceLoop = m_sequenceLoops.find(curByte);
                 if (CAN_UNBOX() && op.escape) {
                     forIterUnboxed(op.jumpsTo);
+                } else if (sequenceLoop != m_sequenceLoops.end()) {
+                    forIter(op.jumpsTo, &sequenceLoop->second);
+                } else if (m_unpackLoops.find(curByte) != m_unpackLoops.end()) {
+                    forIter(op.jumpsTo, nullptr, true);
                 } else {
                     forIter(op.jumpsTo);
                 }
@@ -2469,6 +2697,10 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 break;
             }
             case CALL_METHOD: {
+                if (CAN_UNBOX() && op.escape) {
+                    nativeMathCall(edges, op.index);
+                    break;
+                }
                 if (!m_comp->emit_method_call(oparg)) {
                     buildTuple(oparg);
                     m_comp->emit_method_call_n();
@@ -2486,7 +2718,10 @@ AbstactInterpreterCompileResult AbstractInterpreter::compileWorker(PgcStatus pgc
                 break;
             }
             case YIELD_VALUE: {
-                yieldValue(op.index, curStackSize, graph);
+                if (mConsumerEnabled)
+                    consumeValue(op.index);
+                else
+                    yieldValue(op.index, curStackSize, graph);
                 break;
             }
             case GEN_START: {
@@ -2560,7 +2795,7 @@ InstructionGraph* AbstractInterpreter::buildInstructionGraph(bool escapeLocals)
     for (const auto& state : mStartStates) {
         stacks[state.first] = &state.second.mStack;
     }
-    return new InstructionGraph(mCode, stacks, escapeLocals);
+    return new InstructionGraph(mCode, stacks, escapeLocals, mDirectVariantEnabled);
 }
 
 AbstactInterpreterCompileResult AbstractInterpreter::compile(PyObject* builtins, PyObject* globals, PyjionCodeProfile* profile, PgcStatus pgc_status) {
@@ -2569,10 +2804,10 @@ AbstactInterpreterCompileResult AbstractInterpreter::compile(PyObject* builtins,
         if (interpreted != Success) {
             return {nullptr, interpreted};
         }
-        bool unboxVars = OPT_ENABLED(Unboxing) && !(mCode->co_flags & CO_GENERATOR);
+        bool unboxVars = OPT_ENABLED(Unboxing) && !suspends();
         auto instructionGraph = buildInstructionGraph(unboxVars);
         auto result = compileWorker(pgc_status, instructionGraph);
-        if (g_pyjionSettings.graph) {
+        if (PyJit_Settings().graph) {
             result.instructionGraph = instructionGraph->makeGraph(PyUnicode_AsUTF8(mCode->co_name));
 
             //            // This snippet is really useful from time to time. Keep it here commented out
@@ -2664,12 +2899,17 @@ void AbstractInterpreter::returnValue(py_opindex opcodeIndex) {
     decStack();
 }
 
-void AbstractInterpreter::forIter(py_opindex loopIndex) {
+void AbstractInterpreter::forIter(py_opindex loopIndex, SequenceLoop* sequence, bool unpack) {
     // dup the iter so that it stays on the stack for the next iteration
     m_comp->emit_dup();// ..., iter -> iter, iter, ...
 
     // emits NULL on error, 0xff on StopIter and ptr on next
-    m_comp->emit_for_next();// ..., iter, iter -> iter, iter(), ...
+    if (sequence != nullptr)
+        m_comp->emit_for_next_sequence(sequence->index, sequence->size, sequence->iterable);
+    else if (unpack)
+        m_comp->emit_for_next_unpack();
+    else
+        m_comp->emit_for_next();// ..., iter, iter -> iter, iter(), ...
 
     /* Check for SIG_ITER_ERROR on the stack, indicating error (not stopiter) */
     auto noErr = m_comp->emit_define_label();
@@ -2701,6 +2941,461 @@ void AbstractInterpreter::forIter(py_opindex loopIndex) {
     m_comp->emit_mark_label(next);
 }
 
+/* Matches `for a, b in enumerate(...)` and `for a, b in zip(...)`, where CALL_FUNCTION is followed by GET_ITER,
+ * FOR_ITER and an UNPACK_SEQUENCE of the same width. Returns the width, or 0 if the call can't be replaced. */
+size_t AbstractInterpreter::unpackLoopWidth(py_opindex opcodeIndex, py_oparg oparg, InterpreterStack& stackInfo) {
+    if (!OPT_ENABLED(InlineIterators) || suspends() || oparg == 0 || stackInfo.size() < oparg + 1)
+        return 0;
+    if (opcodeIndex + 3 * SIZEOF_CODEUNIT >= mSize ||
+        GET_OPCODE(opcodeIndex + SIZEOF_CODEUNIT) != GET_ITER ||
+        GET_OPCODE(opcodeIndex + 2 * SIZEOF_CODEUNIT) != FOR_ITER ||
+        GET_OPCODE(opcodeIndex + 3 * SIZEOF_CODEUNIT) != UNPACK_SEQUENCE)
+        return 0;
+    size_t width = GET_OPARG(opcodeIndex + 3 * SIZEOF_CODEUNIT);
+    switch (knownFunctionReturnType(stackInfo.nth(oparg + 1))) {
+        case AVK_Enumerate:
+            return (oparg <= 2 && width == 2) ? width : 0;
+        case AVK_Zip:
+            return width == oparg ? width : 0;
+        default:
+            return 0;
+    }
+}
+
+/* Matches the UNPACK_SEQUENCE 2 of `for i, x in enumerate(...)`, right after the FOR_ITER over the GET_ITER of the
+ * call, whose counter (on top) is always an int. */
+bool AbstractInterpreter::enumerateStep(py_opindex opcodeIndex) {
+    if (GET_OPARG(opcodeIndex) != 2 || opcodeIndex < 3 * SIZEOF_CODEUNIT || m_jumpsTo.find(opcodeIndex) != m_jumpsTo.end() ||
+        GET_OPCODE(opcodeIndex - SIZEOF_CODEUNIT) != FOR_ITER ||
+        GET_OPCODE(opcodeIndex - 2 * SIZEOF_CODEUNIT) != GET_ITER ||
+        GET_OPCODE(opcodeIndex - 3 * SIZEOF_CODEUNIT) != CALL_FUNCTION)
+        return false;
+    auto call = opcodeIndex - 3 * SIZEOF_CODEUNIT;
+    auto callArgs = GET_OPARG(call);
+    auto& stackInfo = getStackInfo(call);
+    return (callArgs == 1 || callArgs == 2) && stackInfo.size() >= callArgs + 1 &&
+           knownFunctionReturnType(stackInfo.nth(callArgs + 1)) == AVK_Enumerate;
+}
+
+/* Unpacks a step of `for i, x in enumerate(...)` whose counter is stored to an unboxed local, see
+ * InstructionGraph::isEnumerateStep(). The iterator from emit_unpack_iter_new() hands out the counter without
+ * boxing it, any other iterator (e.g. enumerate() of a generator) is unpacked as usual and its counter unboxed. */
+void AbstractInterpreter::unpackEnumerate(bool unpackIter, AbstractValueWithSources iterable, py_opindex curByte) {
+    auto generic = m_comp->emit_define_label(), done = m_comp->emit_define_label();
+    if (unpackIter) {
+        m_comp->emit_unpack_enumerate(generic);
+        m_comp->emit_branch(BranchAlways, done);
+    }
+    m_comp->emit_mark_label(generic);
+    m_comp->emit_unpack_sequence(2, iterable);
+    decStack();
+    incStack(2);
+    intErrorCheck("failed to unpack sequence", iterable.Value->describe(), curByte);
+
+    // enumerate() could have been rebound since the function was compiled
+    Local failure = m_comp->emit_define_local(LK_Int);
+    auto unboxed = m_comp->emit_define_label();
+    m_comp->emit_int(0);
+    m_comp->emit_store_local(failure);
+    m_comp->emit_unbox(AVK_Integer, true, failure);
+    decStack();
+    incStack(1, LK_Int);
+    m_comp->emit_load_and_free_local(failure);
+    m_comp->emit_branch(BranchFalse, unboxed);
+    branchRaise("failed unboxing enumerate counter", "", curByte);
+    m_comp->emit_mark_label(unboxed);
+    m_comp->emit_mark_label(done);
+}
+
+/* Matches `for k in d`, `for k in d.keys()`, `for v in d.values()` and `for k, v in d.items()` on a dict, where GET_ITER
+ * is followed by FOR_ITER (and for items(), an UNPACK_SEQUENCE of 2). Returns the items per step, or 0 for any other loop. */
+size_t AbstractInterpreter::dictLoopWidth(py_opindex opcodeIndex, InterpreterStack& stackInfo) {
+    if (!OPT_ENABLED(InlineIterators) || suspends())
+        return 0;
+    if (opcodeIndex + SIZEOF_CODEUNIT >= mSize || GET_OPCODE(opcodeIndex + SIZEOF_CODEUNIT) != FOR_ITER)
+        return 0;
+    if (!stackInfo.empty() && stackInfo.top().hasValue() && stackInfo.top().Value->kind() == AVK_Dict)
+        return 1;
+
+    // The view comes from LOAD_METHOD, CALL_METHOD 0 right before GET_ITER
+    if (opcodeIndex < 2 * SIZEOF_CODEUNIT ||
+        GET_OPCODE(opcodeIndex - SIZEOF_CODEUNIT) != CALL_METHOD || GET_OPARG(opcodeIndex - SIZEOF_CODEUNIT) != 0 ||
+        GET_OPCODE(opcodeIndex - 2 * SIZEOF_CODEUNIT) != LOAD_METHOD ||
+        (opcodeIndex >= 3 * SIZEOF_CODEUNIT && GET_OPCODE(opcodeIndex - 3 * SIZEOF_CODEUNIT) == EXTENDED_ARG))
+        return 0;
+    auto& receiver = getStackInfo(opcodeIndex - 2 * SIZEOF_CODEUNIT);
+    if (receiver.empty() || !receiver.top().hasValue() || receiver.top().Value->kind() != AVK_Dict)
+        return 0;
+    auto name = PyUnicode_AsUTF8(PyTuple_GetItem(mCode->co_names, GET_OPARG(opcodeIndex - 2 * SIZEOF_CODEUNIT)));
+    if (name == nullptr) {
+        PyErr_Clear();
+        return 0;
+    }
+    if (strcmp(name, "keys") == 0 || strcmp(name, "values") == 0)
+        return 1;
+    if (strcmp(name, "items") == 0 && opcodeIndex + 2 * SIZEOF_CODEUNIT < mSize &&
+        GET_OPCODE(opcodeIndex + 2 * SIZEOF_CODEUNIT) == UNPACK_SEQUENCE && GET_OPARG(opcodeIndex + 2 * SIZEOF_CODEUNIT) == 2)
+        return 2;
+    return 0;
+}
+
+// Generators lose their IL locals when they yield, except for the consumer variant of a generator expression which never does
+bool AbstractInterpreter::suspends() {
+    return (mCode->co_flags & CO_GENERATOR) && !mConsumerEnabled;
+}
+
+/* Matches the start of a list or dict comprehension, BUILD_LIST 0 or BUILD_MAP 0 followed by the loop over the
+ * iterator it's called with, so the container can be presized from the iterator. */
+bool AbstractInterpreter::startsComprehension(py_opindex opcodeIndex) {
+    return mCode->co_argcount == 1 && !(mCode->co_flags & CO_GENERATOR) &&
+           opcodeIndex + 2 * SIZEOF_CODEUNIT < mSize &&
+           GET_OPCODE(opcodeIndex + SIZEOF_CODEUNIT) == LOAD_FAST && GET_OPARG(opcodeIndex + SIZEOF_CODEUNIT) == 0 &&
+           GET_OPCODE(opcodeIndex + 2 * SIZEOF_CODEUNIT) == FOR_ITER;
+}
+
+/* Matches BUILD_TUPLE n immediately unpacked by UNPACK_SEQUENCE n, as compiled for a, b, c, d = d, c, b, a.
+ * The UNPACK_SEQUENCE must not be a jump target, otherwise it can receive a tuple built elsewhere. */
+bool AbstractInterpreter::buildsUnpackedTuple(py_opindex opcodeIndex) {
+    auto next = opcodeIndex + SIZEOF_CODEUNIT;
+    return GET_OPCODE(opcodeIndex) == BUILD_TUPLE && next < mSize &&
+           (opcodeIndex < SIZEOF_CODEUNIT || GET_OPCODE(opcodeIndex - SIZEOF_CODEUNIT) != EXTENDED_ARG) &&
+           GET_OPCODE(next) == UNPACK_SEQUENCE && GET_OPARG(next) == GET_OPARG(opcodeIndex) &&
+           m_jumpsTo.find(next) == m_jumpsTo.end();
+}
+
+/* Reorders the top order.size() values of the stack through IL locals, order lists the values to push back
+ * by their depth before the reorder. Values arriving on unboxed edges stay unboxed. */
+void AbstractInterpreter::reorderStack(const vector<size_t>& order, const vector<Edge>& edges) {
+    vector<AbstractValueKind> kinds(order.size(), AVK_Any);
+    for (auto& edge : edges) {
+        if (edge.position < kinds.size())
+            kinds[edge.position] = edge.kind;
+    }
+    vector<Local> values(order.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = m_comp->emit_define_local(kinds[i]);
+        m_comp->emit_store_local(values[i]);
+    }
+    decStack(values.size());
+    for (auto i : order) {
+        m_comp->emit_load_and_free_local(values[i]);
+        incStack(1, avkAsStackEntryKind(kinds[i]));
+    }
+}
+
+/* Matches a generator expression passed on its own to sum(), any(), all(), min(), max(), list(), tuple() or set(),
+ * where the CALL_FUNCTION 1 before creates the generator from GET_ITER. Returns the PyjionConsumerKind, or -1. */
+int32_t AbstractInterpreter::generatorConsumer(py_opindex opcodeIndex, py_oparg oparg, InterpreterStack& stackInfo) {
+    if (!OPT_ENABLED(InlineIterators) || mTracingEnabled || mProfilingEnabled || oparg != 1 || stackInfo.size() < 2)
+        return -1;
+    if (opcodeIndex < 2 * SIZEOF_CODEUNIT ||
+        GET_OPCODE(opcodeIndex - SIZEOF_CODEUNIT) != CALL_FUNCTION || GET_OPARG(opcodeIndex - SIZEOF_CODEUNIT) != 1 ||
+        GET_OPCODE(opcodeIndex - 2 * SIZEOF_CODEUNIT) != GET_ITER)
+        return -1;
+    auto function = stackInfo.second();
+    if (!function.hasSource() || !function.Sources->isBuiltin())
+        return -1;
+    const char* consumers[] = {"sum", "any", "all", "min", "max", "list", "tuple", "set"};
+    auto name = dynamic_cast<BuiltinSource*>(function.Sources)->getName();
+    for (int32_t kind = ConsumeSum; kind <= ConsumeSet; kind++) {
+        if (strcmp(name, consumers[kind]) == 0)
+            return kind;
+    }
+    return -1;
+}
+
+/* Compiles math.sqrt(x), math.floor(x), ... on an unboxed argument as a direct call to libm. The method loaded from
+ * the module is checked to be the builtin, anything else goes through MethCall1 and has its result unboxed. floor() and
+ * ceil() return an int object, boxed inline when it fits in 64 bits and otherwise made a big int as math_floor() does. */
+void AbstractInterpreter::nativeMathCall(const vector<Edge>& edges, py_opindex curByte) {
+    PyMethodDef* def = nullptr;
+    auto argKind = edges[0].kind;
+    auto function = nativeMathFunction(dynamic_cast<GlobalValue*>(edges[2].value)->lastValue(),
+                                       dynamic_cast<MethodSource*>(edges[1].source)->name(), argKind, &def);
+    if (function == nullptr)
+        throw UnexpectedValueException();
+    auto resultKind = function->returnsInt ? AVK_Integer : AVK_Float;
+
+    Local arg = m_comp->emit_define_local(argKind);
+    m_comp->emit_store_local(arg);
+    Local methodInfo = m_comp->emit_define_local(LK_Pointer);
+    m_comp->emit_store_local(methodInfo);
+    Local self = m_comp->emit_define_local(LK_Pointer);
+    m_comp->emit_store_local(self);
+    decStack(3);
+
+    Local value = function->returnsInt ? m_comp->emit_define_local(LK_Pointer) : m_comp->emit_define_local(resultKind);
+    auto fallback = m_comp->emit_define_label(), noErr = m_comp->emit_define_label(), done = m_comp->emit_define_label();
+    m_comp->emit_load_local(methodInfo);
+    m_comp->emit_check_math_method(def);
+    m_comp->emit_branch(BranchFalse, fallback);
+
+    // self is the module, which PyJit_LoadMethod already released
+    Local x = m_comp->emit_define_local(LK_Float);
+    Local result = m_comp->emit_define_local(LK_Float);
+    m_comp->emit_load_local(arg);
+    if (argKind != AVK_Float)
+        m_comp->emit_int_to_float();
+    m_comp->emit_store_local(x);
+    m_comp->emit_load_local(x);
+    m_comp->emit_math_function(function);
+    m_comp->emit_store_local(result);
+    m_comp->emit_load_local(result);
+    m_comp->emit_math_result_check(function);
+    if (function->returnsInt) {
+        auto inRange = m_comp->emit_define_label();
+        m_comp->emit_branch(BranchTrue, inRange);
+        // Results beyond the int64 range convert to a big int, infinity and NaN raise the builtin's errors
+        m_comp->emit_load_local(result);
+        m_comp->emit_float_to_int_object();
+        errorCheck("math function failed", function->name, curByte);
+        m_comp->emit_store_local(value);
+        m_comp->emit_branch(BranchAlways, done);
+        m_comp->emit_mark_label(inRange);
+        m_comp->emit_load_local(result);
+        m_comp->emit_float_to_int();
+        m_comp->emit_box(AVK_Integer);
+    } else {
+        m_comp->emit_branch(BranchTrue, noErr);
+        m_comp->emit_load_local(x);
+        m_comp->emit_load_local(result);
+        m_comp->emit_math_error(function);
+        m_comp->emit_branch(BranchFalse, noErr);
+        branchRaise("math function failed", function->name, curByte);
+        m_comp->emit_mark_label(noErr);
+        m_comp->emit_load_local(result);
+    }
+    m_comp->emit_store_local(value);
+    m_comp->emit_branch(BranchAlways, done);
+
+    m_comp->emit_mark_label(fallback);
+    m_comp->emit_load_local(self);
+    m_comp->emit_load_local(methodInfo);
+    m_comp->emit_load_local(arg);
+    m_comp->emit_box(argKind);
+    m_comp->emit_method_call(1);
+    errorCheck("failed to call method", "", curByte);
+    if (function->returnsInt) {
+        m_comp->emit_store_local(value);
+    } else {
+        Local success = m_comp->emit_define_local(LK_Int);
+        auto unboxed = m_comp->emit_define_label();
+        m_comp->emit_int(0);
+        m_comp->emit_store_local(success);
+        m_comp->emit_unbox(resultKind, true, success);
+        m_comp->emit_store_local(value);
+        m_comp->emit_load_and_free_local(success);
+        m_comp->emit_branch(BranchFalse, unboxed);
+        branchRaise("failed unboxing math function result", function->name, curByte);
+        m_comp->emit_mark_label(unboxed);
+    }
+
+    m_comp->emit_mark_label(done);
+    m_comp->emit_load_and_free_local(value);
+    m_comp->emit_free_local(arg);
+    m_comp->emit_free_local(methodInfo);
+    m_comp->emit_free_local(self);
+    m_comp->emit_free_local(x);
+    m_comp->emit_free_local(result);
+    if (function->returnsInt)
+        incStack();
+    else
+        incStack(1, LK_Float);
+}
+
+/* Compiles a call to len(), abs(), min(), max() or isinstance() inline, see inlineBuiltin(). The function loaded from
+ * the builtins and the type passed to isinstance() are checked first, anything else is called as usual. */
+void AbstractInterpreter::inlineBuiltinCall(InlineBuiltin builtin, const vector<Edge>& edges, py_oparg oparg, py_opindex curByte) {
+    bool unboxedArgs = inlineBuiltinUnboxesArgs(builtin);
+    vector<AbstractValueKind> kinds(oparg);
+    vector<Local> args(oparg);
+    for (py_oparg i = 0; i < oparg; i++) {
+        kinds[i] = edges[oparg - 1 - i].kind;
+        args[i] = unboxedArgs ? m_comp->emit_define_local(kinds[i]) : m_comp->emit_define_local(LK_Pointer);
+    }
+    for (py_oparg i = oparg; i > 0; i--) {
+        m_comp->emit_store_local(args[i - 1]);
+    }
+    Local function = m_comp->emit_define_local(LK_Pointer);
+    m_comp->emit_store_local(function);
+    decStack(oparg + 1);
+
+    auto resultKind = inlineBuiltinKind(builtin, kinds);
+    Local value = inlineBuiltinBoxesResult(builtin) ? m_comp->emit_define_local(LK_Pointer) : m_comp->emit_define_local(resultKind);
+    auto fallback = m_comp->emit_define_label(), done = m_comp->emit_define_label();
+    // The global could have been shadowed since it was cached
+    m_comp->emit_load_local(function);
+    m_comp->emit_ptr(dynamic_cast<BuiltinSource*>(edges[oparg].source)->getValue());
+    m_comp->emit_branch(BranchNotEqual, fallback);
+
+    switch (builtin) {
+        case InlineLen:
+            m_comp->emit_len(args[0], AbstractValueWithSources(edges[0].value, edges[0].source), fallback);
+            m_comp->emit_store_local(value);
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_pop_top();
+            break;
+        case InlineAbs:
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_unboxed_abs(resultKind);
+            m_comp->emit_store_local(value);
+            break;
+        case InlineAbsComplex:
+            m_comp->emit_complex_abs(args[0], AbstractValueWithSources(edges[0].value, edges[0].source), fallback);
+            m_comp->emit_store_local(value);
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_pop_top();
+            break;
+        case InlineMin:
+        case InlineMax:
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_load_local(args[1]);
+            m_comp->emit_unboxed_min_max(resultKind, builtin == InlineMax);
+            m_comp->emit_store_local(value);
+            break;
+        case InlineIsInstance: {
+            auto type = dynamic_cast<BuiltinSource*>(edges[0].source)->getValue();
+            m_comp->emit_load_local(args[1]);
+            m_comp->emit_ptr(type);
+            m_comp->emit_branch(BranchNotEqual, fallback);
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_isinstance((PyTypeObject*) type);
+            m_comp->emit_store_local(value);
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_pop_top();
+            m_comp->emit_load_local(args[1]);
+            m_comp->emit_pop_top();
+            break;
+        }
+        case InlineInt:
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_unboxed_to_int(kinds[0]);
+            m_comp->emit_store_local(value);
+            break;
+        case InlineIntFromFloat:
+            // Larger floats are left to int() to convert to a big int, or raise for infinity and NaN
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_float_in_int_range();
+            m_comp->emit_branch(BranchFalse, fallback);
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_unboxed_to_int(kinds[0]);
+            m_comp->emit_box(AVK_Integer);
+            m_comp->emit_store_local(value);
+            break;
+        case InlineFloat:
+            m_comp->emit_load_local(args[0]);
+            if (kinds[0] != AVK_Float)
+                m_comp->emit_int_to_float();
+            m_comp->emit_store_local(value);
+            break;
+        case InlineBool:
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_unboxed_to_bool(kinds[0]);
+            m_comp->emit_store_local(value);
+            break;
+        case InlineStr:
+            m_comp->emit_load_local(args[0]);
+            m_comp->emit_unboxed_int_to_str();
+            m_comp->emit_store_local(value);
+            break;
+        default:
+            throw UnexpectedValueException();
+    }
+    m_comp->emit_load_local(function);
+    m_comp->emit_pop_top();
+    if (builtin == InlineIsInstance) {
+        // -1 if __instancecheck__ or __class__ raised
+        m_comp->emit_load_local(value);
+        m_comp->emit_int(-1);
+        m_comp->emit_branch(BranchNotEqual, done);
+        branchRaise("isinstance failed", "", curByte);
+    } else if (builtin == InlineStr) {
+        m_comp->emit_load_local(value);
+        m_comp->emit_null();
+        m_comp->emit_branch(BranchNotEqual, done);
+        branchRaise("str failed", "", curByte);
+    } else {
+        m_comp->emit_branch(BranchAlways, done);
+    }
+
+    m_comp->emit_mark_label(fallback);
+    m_comp->emit_load_local(function);
+    for (py_oparg i = 0; i < oparg; i++) {
+        m_comp->emit_load_local(args[i]);
+        if (unboxedArgs)
+            m_comp->emit_box(kinds[i]);
+    }
+    m_comp->emit_call_function(oparg);
+    errorCheck("inline builtin call failed", "", curByte);
+    if (inlineBuiltinBoxesResult(builtin)) {
+        m_comp->emit_store_local(value);
+    } else {
+        Local success = m_comp->emit_define_local(LK_Int);
+        auto unboxed = m_comp->emit_define_label();
+        m_comp->emit_int(0);
+        m_comp->emit_store_local(success);
+        m_comp->emit_unbox(resultKind, true, success);
+        m_comp->emit_store_local(value);
+        m_comp->emit_load_and_free_local(success);
+        m_comp->emit_branch(BranchFalse, unboxed);
+        branchRaise("failed unboxing builtin result", "", curByte);
+        m_comp->emit_mark_label(unboxed);
+    }
+
+    m_comp->emit_mark_label(done);
+    m_comp->emit_load_and_free_local(value);
+    for (auto& arg : args) {
+        m_comp->emit_free_local(arg);
+    }
+    m_comp->emit_free_local(function);
+    if (inlineBuiltinBoxesResult(builtin))
+        incStack();
+    else
+        incStack(1, avkAsStackEntryKind(resultKind));
+}
+
+void AbstractInterpreter::directCall(AbstractValueKind kind, const vector<AbstractValueKind>& argKinds, py_oparg oparg, py_opindex curByte) {
+    Local result = m_comp->emit_define_local(kind);
+    auto success = m_comp->emit_define_label();
+    // Unboxed arguments are passed by address, so they are spilled to locals along with the arguments above them
+    py_oparg firstSpilled = oparg;
+    for (py_oparg i = 0; i < oparg; i++) {
+        if (argKinds[i] != AVK_Any) {
+            firstSpilled = i;
+            break;
+        }
+    }
+    vector<Local> args(oparg);
+    for (py_oparg i = oparg; i > firstSpilled; i--) {
+        args[i - 1] = m_comp->emit_define_local(argKinds[i - 1]);
+        m_comp->emit_store_local(args[i - 1]);
+    }
+    for (py_oparg i = firstSpilled; i < oparg; i++) {
+        if (argKinds[i] == AVK_Any)
+            m_comp->emit_load_and_free_local(args[i]);
+        else
+            m_comp->emit_load_local_addr(args[i]);
+    }
+    m_comp->emit_call_direct(oparg, packDirectArgKinds(argKinds), kind, result);
+    for (py_oparg i = firstSpilled; i < oparg; i++) {
+        if (argKinds[i] != AVK_Any)
+            m_comp->emit_free_local(args[i]);
+    }
+    decStack(oparg + 1);
+    m_comp->emit_branch(BranchFalse, success);
+    branchRaise("direct call failed", "", curByte);
+    m_comp->emit_mark_label(success);
+    m_comp->emit_load_and_free_local(result);
+    incStack(1, avkAsStackEntryKind(kind));
+}
+
+void AbstractInterpreter::unboxedReturnValue(AbstractValueKind kind, py_opindex opcodeIndex) {
+    m_comp->emit_unboxed_return(kind);
+    decStack();
+    incStack();
+    returnValue(opcodeIndex);
+}
+
 void AbstractInterpreter::forIterUnboxed(py_opindex loopIndex) {
     // dup the iter so that it stays on the stack for the next iteration
     m_comp->emit_dup();// ..., iter -> iter, iter, ...
@@ -2739,6 +3434,30 @@ void AbstractInterpreter::loadFastUnboxed(py_oparg local, py_opindex opcodeIndex
     m_comp->emit_load_local(m_fastNativeLocals[local]);
     incStack(1, m_fastNativeLocalKinds[local]);
 }
+void AbstractInterpreter::loadLoopBound(py_oparg local, py_opindex entry, py_opindex opcodeIndex) {
+    if (entry != opcodeIndex) {
+        // The bound isn't stored to in the loop, so it still has the value unboxed by the check at the top
+        m_comp->emit_load_local(m_loopBounds[entry]);
+        incStack(1, STACK_KIND_VALUE_INT);
+        return;
+    }
+    bool checkUnbound = m_assignmentState.find(local) == m_assignmentState.end() || !m_assignmentState.find(local)->second;
+    loadFastWorker(local, checkUnbound, opcodeIndex);
+    Local success = m_comp->emit_define_local(LK_Int);
+    auto noError = m_comp->emit_define_label();
+    m_comp->emit_int(0);
+    m_comp->emit_store_local(success);
+    m_comp->emit_unbox(AVK_Integer, true, success);
+    incStack(1, STACK_KIND_VALUE_INT);
+    m_comp->emit_load_and_free_local(success);
+    m_comp->emit_branch(BranchFalse, noError);
+    branchRaise("failed unboxing operation", "", opcodeIndex);
+    m_comp->emit_mark_label(noError);
+    m_loopBounds[entry] = m_comp->emit_define_local(LK_Int);
+    m_comp->emit_dup();
+    m_comp->emit_store_local(m_loopBounds[entry]);
+}
+
 void AbstractInterpreter::storeFastUnboxed(py_oparg local) {
     m_comp->emit_store_local(m_fastNativeLocals[local]);
     decStack();
@@ -2771,7 +3490,7 @@ void AbstractInterpreter::loadFastWorker(py_oparg local, bool checkUnbound, py_o
 
 void AbstractInterpreter::jumpIfOrPop(bool isTrue, py_opindex opcodeIndex, py_oparg jumpTo) {
     if (jumpTo <= opcodeIndex) {
-        m_comp->emit_pending_calls();
+        pendingCalls();
     }
     auto target = getOffsetLabel(jumpTo);
     m_offsetStack[jumpTo] = ValueStack(m_stack);
@@ -2808,7 +3527,7 @@ void AbstractInterpreter::jumpIfOrPop(bool isTrue, py_opindex opcodeIndex, py_op
 
 void AbstractInterpreter::popJumpIf(bool isTrue, py_opindex opcodeIndex, py_oparg jumpTo) {
     if (jumpTo <= opcodeIndex) {
-        m_comp->emit_pending_calls();
+        pendingCalls();
     }
     auto target = getOffsetLabel(jumpTo);
 
@@ -2847,7 +3566,7 @@ void AbstractInterpreter::popJumpIf(bool isTrue, py_opindex opcodeIndex, py_opar
 
 void AbstractInterpreter::unboxedPopJumpIf(bool isTrue, py_opindex opcodeIndex, py_oparg offset, AbstractValueWithSources sources) {
     if (offset <= opcodeIndex) {
-        m_comp->emit_pending_calls();
+        pendingCalls();
     }
     auto target = getOffsetLabel(offset);
     if (!sources.hasValue())
@@ -2870,9 +3589,17 @@ void AbstractInterpreter::unboxedPopJumpIf(bool isTrue, py_opindex opcodeIndex,
     m_offsetStack[offset] = ValueStack(m_stack);
 }
 
+/* Signal handlers and other pending calls can resize lists, so they clear the guards of range loops over lists */
+void AbstractInterpreter::pendingCalls() {
+    vector<Local> guards;
+    for (auto& guard : m_rangeListGuards)
+        guards.push_back(guard.second);
+    m_comp->emit_pending_calls(guards);
+}
+
 void AbstractInterpreter::jumpAbsolute(py_opindex index, py_opindex from) {
     if (index <= from) {
-        m_comp->emit_pending_calls();
+        pendingCalls();
     }
     m_offsetStack[index] = ValueStack(m_stack);
     m_comp->emit_branch(BranchAlways, getOffsetLabel(index));
@@ -2881,7 +3608,7 @@ void AbstractInterpreter::jumpAbsolute(py_opindex index, py_opindex from) {
 void AbstractInterpreter::jumpIfNotExact(py_opindex opcodeIndex, py_oparg jumpTo) {
     Label handle = m_comp->emit_define_label();
     if (jumpTo <= opcodeIndex) {
-        m_comp->emit_pending_calls();
+        pendingCalls();
     }
     auto target = getOffsetLabel(jumpTo);
     m_comp->emit_compare_exceptions();
@@ -2951,3 +3678,16 @@ void AbstractInterpreter::enableProfiling() {
 void AbstractInterpreter::disableProfiling() {
     mProfilingEnabled = false;
 }
+
+void AbstractInterpreter::enableConsumer() {
+    mConsumerEnabled = true;
+}
+
+void AbstractInterpreter::enableDirectVariant() {
+    mDirectVariantEnabled = true;
+}
+
+AbstractValueKind AbstractInterpreter::getDirectArgKind(py_oparg arg) {
+    auto kind = mDirectArgKinds.find(arg);
+    return kind == mDirectArgKinds.end() ? AVK_Any : kind->second;
+}
@@ -251,6 +251,13 @@ struct AbstactInterpreterCompileResult {
     OptimizationFlags optimizations = OptimizationFlags();
 };
 
+// IL locals for a FOR_ITER loop that walks a known list or tuple by index instead of through an iterator
+struct SequenceLoop {
+    Local index;
+    Local size;
+    AbstractValueWithSources iterable;
+};
+
 class StackImbalanceException : public std::exception {
 public:
     StackImbalanceException() : std::exception(){};
@@ -283,6 +290,9 @@ class AbstractInterpreter : public PyjionBase {
     Local mErrorCheckLocal;
     bool mTracingEnabled;
     bool mProfilingEnabled;
+    bool mConsumerEnabled;// Compiling the consumer variant of a generator expression, see PyJit_ConsumeGenerator
+    bool mDirectVariantEnabled;// Compiling the direct variant of a function, see PyJit_CallDirect
+    unordered_map<py_oparg, AbstractValueKind> mDirectArgKinds;// Arguments the direct variant takes unboxed
     Local mTracingLastInstr;
     uint64_t mGlobalsVersion;
     uint64_t mBuiltinsVersion;
@@ -298,6 +308,10 @@ class AbstractInterpreter : public PyjionBase {
     vector<Local> m_raiseAndFreeLocals;
     unordered_map<py_oparg, Local> m_fastNativeLocals;
     unordered_map<py_oparg, StackEntryKind> m_fastNativeLocalKinds;
+    // The bounds of counted while loops, unboxed by the load at the top of the loop
+    unordered_map<py_opindex, Local> m_loopBounds;
+    // Whether the range of a range loop over list indexes is in range of the lists, set by the GET_ITER of the loop
+    unordered_map<py_opindex, Local> m_rangeListGuards;
     IPythonCompiler* m_comp;
     // m_blockStack is like Python's f_blockstack which lives on the frame object, except we only maintain
     // it at compile time.  Blocks are pushed onto the stack when we enter a loop, the start of a try block,
@@ -315,6 +329,14 @@ class AbstractInterpreter : public PyjionBase {
     // Tracks the state of the stack when we perform a branch.  We copy the existing state to the map and
     // reload it when we begin processing at the stack.
     unordered_map<py_opindex, ValueStack> m_offsetStack;
+    // Loops over a known list or tuple, keyed by the offset of their FOR_ITER
+    unordered_map<py_opindex, SequenceLoop> m_sequenceLoops;
+    // Offsets of the FOR_ITER of loops over enumerate(), zip() or dicts that get their steps without a tuple
+    unordered_set<py_opindex> m_unpackLoops;
+    // Offsets of the UNPACK_SEQUENCE that takes the items of those steps
+    unordered_set<py_opindex> m_unpackSteps;
+    // Set when the list of a list comprehension was presized, the unused room is given back when it's returned
+    bool m_trimListOnReturn = false;
     unordered_map<py_oparg, Py_ssize_t> nameHashes;
     unordered_map<py_oparg, PyObject*> lastResolvedGlobal;
 
@@ -342,6 +364,8 @@ public:
     AbstractInterpreterResult interpret(PyObject* builtins, PyObject* globals, PyjionCodeProfile* profile, PgcStatus status);
 
     void setLocalType(size_t index, PyObject* val);
+    // Declares the type of an argument without an observed value, used for ahead-of-time compilation.
+    void setLocalType(size_t index, PyTypeObject* type);
     // Returns information about the specified local variable at a specific
     // byte code index.
     AbstractLocalInfo getLocalInfo(py_opindex byteCodeIndex, size_t localIndex);
@@ -355,6 +379,9 @@ public:
     void disableTracing();
     void enableProfiling();
     void disableProfiling();
+    void enableConsumer();
+    void enableDirectVariant();
+    AbstractValueKind getDirectArgKind(py_oparg arg);
     InstructionGraph* buildInstructionGraph(bool escapeLocals);
 
 private:
@@ -385,10 +412,24 @@ private:
     void emitPgcProbes(py_opindex pos, size_t size, const vector<Edge>& edges);
 
     Label getOffsetLabel(py_opindex jumpTo);
-    void forIter(py_opindex loopIndex);
+    void forIter(py_opindex loopIndex, SequenceLoop* sequence = nullptr, bool unpack = false);
+    size_t unpackLoopWidth(py_opindex opcodeIndex, py_oparg oparg, InterpreterStack& stackInfo);
+    bool enumerateStep(py_opindex opcodeIndex);
+    void unpackEnumerate(bool unpackIter, AbstractValueWithSources iterable, py_opindex curByte);
+    size_t dictLoopWidth(py_opindex opcodeIndex, InterpreterStack& stackInfo);
+    int32_t generatorConsumer(py_opindex opcodeIndex, py_oparg oparg, InterpreterStack& stackInfo);
+    bool suspends();
+    bool startsComprehension(py_opindex opcodeIndex);
+    bool buildsUnpackedTuple(py_opindex opcodeIndex);
+    void reorderStack(const vector<size_t>& order, const vector<Edge>& edges);
+    void nativeMathCall(const vector<Edge>& edges, py_opindex curByte);
+    void inlineBuiltinCall(InlineBuiltin builtin, const vector<Edge>& edges, py_oparg oparg, py_opindex curByte);
+    void directCall(AbstractValueKind kind, const vector<AbstractValueKind>& argKinds, py_oparg oparg, py_opindex curByte);
+    void unboxedReturnValue(AbstractValueKind kind, py_opindex opcodeIndex);
     void forIterUnboxed(py_opindex loopIndex);
 
     void yieldValue(py_opindex idx, size_t stackSize, InstructionGraph* graph);
+    void consumeValue(py_opindex idx);
 
     // Checks to see if we have a null value as the last value on our stack
     // indicating an error, and if so, branches to our current error handler.
@@ -404,6 +445,7 @@ private:
     void unwindEh(ExceptionHandler* fromHandler, ExceptionHandler* toHandler = nullptr);
     ExceptionHandler* currentHandler();
     void markOffsetLabel(py_opindex index);
+    void pendingCalls();
     void jumpAbsolute(py_opindex index, py_opindex from);
     void decStack(size_t size = 1);
     void incStack(size_t size = 1, StackEntryKind kind = STACK_KIND_OBJECT);
@@ -415,6 +457,7 @@ private:
     void storeFastUnboxed(py_oparg local);
     void loadFast(py_oparg local, py_opindex opcodeIndex);
     void loadFastUnboxed(py_oparg local, py_opindex opcodeIndex);
+    void loadLoopBound(py_oparg local, py_opindex entry, py_opindex opcodeIndex);
     void loadFastWorker(py_oparg local, bool checkUnbound, py_opindex curByte);
     void popExcept();
     void jumpIfOrPop(bool isTrue, py_opindex opcodeIndex, py_oparg offset);
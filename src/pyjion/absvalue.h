@@ -729,7 +729,7 @@ public:
         return true;
     }
     PyObject* lastValue() {
-        if (_PyObject_IsFreed(_object) || _object == (PyObject*) 0xFFFFFFFFFFFFFFFF)
+        if (_object == nullptr || _PyObject_IsFreed(_object) || _object == (PyObject*) 0xFFFFFFFFFFFFFFFF)
             return nullptr;
         return _object;
     }
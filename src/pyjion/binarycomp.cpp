@@ -122,7 +122,47 @@ void PythonCompiler::emit_binary_object(uint16_t opcode) {
     }
 }
 
+static bool isComplexOperand(AbstractValueWithSources& value) {
+    if (!value.hasValue())
+        return false;
+    switch (value.Value->kind()) {
+        case AVK_Complex:
+        case AVK_Float:
+        case AVK_Integer:
+        case AVK_Bool:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Add, subtract, multiply and true divide of a complex with a complex, float, int or bool are computed on the
+ * Py_complex values by PyJit_ComplexBinaryOp, which reuses temporary operands for the result. */
+static bool isComplexArithmetic(uint16_t opcode, AbstractValueWithSources& left, AbstractValueWithSources& right) {
+    switch (opcode) {
+        case BINARY_ADD:
+        case INPLACE_ADD:
+        case BINARY_SUBTRACT:
+        case INPLACE_SUBTRACT:
+        case BINARY_MULTIPLY:
+        case INPLACE_MULTIPLY:
+        case BINARY_TRUE_DIVIDE:
+        case INPLACE_TRUE_DIVIDE:
+            break;
+        default:
+            return false;
+    }
+    return isComplexOperand(left) && isComplexOperand(right) &&
+           (left.Value->kind() == AVK_Complex || right.Value->kind() == AVK_Complex);
+}
+
 void PythonCompiler::emit_binary_object(uint16_t opcode, AbstractValueWithSources left, AbstractValueWithSources right) {
+    if (isComplexArithmetic(opcode, left, right)) {
+        m_il.ld_i4(opcode);
+        m_il.emit_call(METHOD_COMPLEX_BINARY_OP);
+        return;
+    }
+
     int nb_slot = -1;
     int sq_slot = -1;
     int fallback_token;
@@ -0,0 +1,118 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) Microsoft Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include "codearena.h"
+
+#ifdef WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define CODE_ARENA_CHUNK_SIZE (1024 * 1024)
+
+CodeArena g_codeArena;
+
+static size_t pageSize() {
+#ifdef WINDOWS
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return systemInfo.dwPageSize;
+#else
+    return sysconf(_SC_PAGESIZE);
+#endif
+}
+
+bool CodeArena::addChunk(size_t minimumSize) {
+    size_t page = pageSize();
+    size_t size = minimumSize > CODE_ARENA_CHUNK_SIZE ? minimumSize : CODE_ARENA_CHUNK_SIZE;
+    size = (size + page - 1) / page * page;
+#ifdef WINDOWS
+    void* base = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+    if (base == nullptr)
+        return false;
+#else
+#if defined(__APPLE__) && defined(MAP_JIT)
+    const int mode = MAP_PRIVATE | MAP_ANONYMOUS | MAP_JIT;
+#elif defined(MAP_ANONYMOUS)
+    const int mode = MAP_PRIVATE | MAP_ANONYMOUS;
+#elif defined(MAP_ANON)
+    const int mode = MAP_PRIVATE | MAP_ANON;
+#else
+#error "not supported"
+#endif
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, mode, -1, 0);
+    if (base == MAP_FAILED)
+        return false;
+#endif
+    m_chunks.push_back(Chunk{(uint8_t*) base, size, 0, false});
+    return true;
+}
+
+void* CodeArena::allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (!m_chunks.empty()) {
+        auto& chunk = m_chunks.back();
+        size_t offset = (chunk.used + alignment - 1) & ~(alignment - 1);
+        if (!chunk.frozen && offset + size <= chunk.size) {
+            chunk.used = offset + size;
+            return chunk.base + offset;
+        }
+    }
+    if (!addChunk(size))
+        return nullptr;
+    auto& chunk = m_chunks.back();
+    chunk.used = size;
+    return chunk.base;
+}
+
+size_t CodeArena::freeze() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    size_t sealed = 0;
+    for (auto& chunk : m_chunks) {
+        if (!chunk.frozen) {
+#ifdef WINDOWS
+            DWORD oldProtect;
+            VirtualProtect(chunk.base, chunk.size, PAGE_EXECUTE_READ, &oldProtect);
+#elif !(defined(__APPLE__) && defined(HOST_ARM64))
+            // MAP_JIT pages on Apple silicon are already write protected, see pthread_jit_write_protect_np
+            mprotect(chunk.base, chunk.size, PROT_READ | PROT_EXEC);
+#endif
+            chunk.frozen = true;
+        }
+        sealed += chunk.used;
+    }
+    return sealed;
+}
+
+size_t CodeArena::committed() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    size_t total = 0;
+    for (auto& chunk : m_chunks) {
+        total += chunk.size;
+    }
+    return total;
+}
@@ -0,0 +1,60 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) Microsoft Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#ifndef PYJION_CODEARENA_H
+#define PYJION_CODEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/* Allocates the machine code of compiled methods from large executable chunks, so the code of many methods is packed
+ * together instead of taking a mapping (and at least a page) each. Memory is never returned, compiled code lives as
+ * long as the process.
+ *
+ * freeze() makes every chunk allocated so far read-only and executable, later allocations start a new chunk. */
+class CodeArena {
+    struct Chunk {
+        uint8_t* base;
+        size_t size;
+        size_t used;
+        bool frozen;
+    };
+    std::vector<Chunk> m_chunks;
+    std::mutex m_lock;// clrjit can allocate from several threads, see PyJit_PrecompileBatch
+
+    bool addChunk(size_t minimumSize);
+
+public:
+    void* allocate(size_t size, size_t alignment = 16);
+    /* Seal all the chunks allocated so far, returns the number of bytes of code in them. */
+    size_t freeze();
+    size_t committed();
+};
+
+extern CodeArena g_codeArena;
+
+#endif// PYJION_CODEARENA_H
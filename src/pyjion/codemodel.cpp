@@ -32,6 +32,7 @@ int BaseModule::AddMethod(CorInfoType returnType, std::vector<Parameter> params,
     if (existingSlots.find(addr) == existingSlots.end()) {
         int token = METHOD_SLOT_SPACE + ++slotCursor;
         m_methods[token] = new JITMethod(this, returnType, std::move(params), addr, false);
+        existingSlots[addr] = token;
         RegisterSymbol(token, label);
         return token;
     } else {
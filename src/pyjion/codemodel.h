@@ -77,7 +77,11 @@ public:
     BaseModule() = default;
 
     virtual BaseMethod* ResolveMethod(int32_t tokenId) {
-        return m_methods[tokenId];
+        // find() rather than [], a lookup must not insert as clrjit can resolve tokens from several threads
+        auto res = m_methods.find(tokenId);
+        if (res == m_methods.end())
+            return nullptr;
+        return res->second;
     }
 
     virtual int AddMethod(CorInfoType returnType, std::vector<Parameter> params, void* addr, const char* label = "typeslot");
@@ -262,6 +262,10 @@ public:
         push_back(CEE_LDIND_R8);// PopI + PopI / Push0
     }
 
+    void st_ind_r8() {
+        push_back(CEE_STIND_R8);// PopI + PopR8 / Push0
+    }
+
     void branch(BranchType branchType, Label label) {
         auto info = &m_labels[label.m_index];
         if (info->m_location == -1) {
@@ -466,6 +470,10 @@ public:
         push_back(CEE_CONV_R8);
     }
 
+    void conv_i8() {
+        push_back(CEE_CONV_I8);
+    }
+
     void ld_i(int32_t i) {
         push_back(CEE_LDC_I4);
         emit_int(i);
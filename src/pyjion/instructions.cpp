@@ -27,9 +27,11 @@
 #include "pycomp.h"
 #include "unboxing.h"
 #include <set>
+#include <algorithm>
 
-InstructionGraph::InstructionGraph(PyCodeObject* code, unordered_map<py_opindex, const InterpreterStack*> stacks, bool escapeLocals) {
+InstructionGraph::InstructionGraph(PyCodeObject* code, unordered_map<py_opindex, const InterpreterStack*> stacks, bool escapeLocals, bool directVariant) {
     this->code = code;
+    this->directVariant = directVariant;
     auto mByteCode = (_Py_CODEUNIT*) PyBytes_AS_STRING(code->co_code);
     auto size = PyBytes_Size(code->co_code);
     for (py_opindex curByte = 0; curByte < size; curByte += SIZEOF_CODEUNIT) {
@@ -76,24 +78,29 @@ InstructionGraph::InstructionGraph(PyCodeObject* code, unordered_map<py_opindex,
     }
     fixInstructions();
     if (escapeLocals) {
-        fixLocals(code->co_argcount, code->co_nlocals);
+        // The direct variant of a function can also take its int and float arguments unboxed
+        fixLocals(directVariant ? 0 : code->co_argcount, code->co_nlocals);
+        fixLoopBounds();
     }
     deoptimizeInstructions();
+    fixRangeListLoops();
     fixEdges();
 }
 
 void InstructionGraph::fixEdges() {
     for (auto& edge : this->edges) {
-        if (!this->instructions[edge.from].escape) {
+        bool fromObject = !this->instructions[edge.from].escape || isBoxedOutput(edge);
+        bool toObject = !this->instructions[edge.to].escape || isBoxedInput(edge);
+        if (fromObject) {
             // From non-escaped operation
-            if (this->instructions[edge.to].escape) {
+            if (!toObject) {
                 edge.escaped = Unbox;
             } else {
                 edge.escaped = NoEscape;
             }
         } else {
             // From escaped operation
-            if (this->instructions[edge.to].escape) {
+            if (!toObject) {
                 edge.escaped = Unboxed;
             } else {
                 edge.escaped = Box;
@@ -108,6 +115,43 @@ void InstructionGraph::fixInstructions() {
             continue;
         if (instruction.second.opcode == LOAD_FAST || instruction.second.opcode == STORE_FAST || instruction.second.opcode == DELETE_FAST)
             continue;// handled in fixLocals();
+        if (instruction.second.opcode == BUILD_TUPLE && !isUnpackedTuple(instruction.first))
+            continue;
+        if (instruction.second.opcode == CALL_METHOD) {
+            auto function = nativeMathCall(instruction.first);
+            instruction.second.escape = function != nullptr;
+            if (function != nullptr && function->returnsInt)
+                nativeMathIntCalls.insert(instruction.first);
+            continue;
+        }
+        if (instruction.second.opcode == CALL_FUNCTION) {
+            auto builtin = inlineBuiltinCall(instruction.first);
+            if (builtin != NoInlineBuiltin) {
+                inlineBuiltins[instruction.first] = builtin;
+                instruction.second.escape = true;
+                continue;
+            }
+            auto kind = directCallKind(instruction.first);
+            if (kind != AVK_Any) {
+                directCalls[instruction.first] = kind;
+                directCallArgs[instruction.first] = directCallArgKinds(instruction.first);
+                instruction.second.escape = true;
+            }
+            continue;
+        }
+        if (instruction.second.opcode == RETURN_VALUE) {
+            instruction.second.escape = isUnboxedReturn(instruction.first);
+            continue;
+        }
+        if (instruction.second.opcode == BINARY_SUBSCR && canIndexList(instruction.first)) {
+            listIndexes.insert(instruction.first);
+            instruction.second.escape = true;
+            continue;
+        }
+        if (instruction.second.opcode == UNPACK_SEQUENCE) {
+            instruction.second.escape = isEnumerateStep(instruction.first);
+            continue;
+        }
 
         // Check that all inbound edges can be escaped.
         bool allEdgesEscapable = true;
@@ -151,7 +195,8 @@ void InstructionGraph::deoptimizeInstructions() {
         auto edgesIn = getEdges(instruction.first);
         auto edgesOut = getEdgesFrom(instruction.first);
         // If the stack effect is wrong..
-        if (PyCompile_OpcodeStackEffect(instruction.second.opcode, instruction.second.oparg) != (edgesOut.size() - edgesIn.size())) {
+        int stackEffect = isUnpackedTuple(instruction.first) ? 0 : PyCompile_OpcodeStackEffect(instruction.second.opcode, instruction.second.oparg);
+        if (stackEffect != (edgesOut.size() - edgesIn.size())) {
 #ifdef DEBUG_VERBOSE
             printf("Warning, instruction has invalid stack effect %s %d\n", opcodeName(instruction.second.opcode), instruction.second.index);
 #endif
@@ -222,6 +267,233 @@ void InstructionGraph::deoptimizeInstructions() {
     }
 }
 
+/* A BUILD_TUPLE immediately unpacked by UNPACK_SEQUENCE of the same size is never allocated, the abstract
+ * interpreter reverses the values on the stack instead and the UNPACK_SEQUENCE consumes nothing. */
+bool InstructionGraph::isUnpackedTuple(py_opindex idx) {
+    if (this->instructions[idx].opcode != BUILD_TUPLE)
+        return false;
+    auto next = this->instructions.find(idx + SIZEOF_CODEUNIT);
+    return next != this->instructions.end() &&
+           next->second.opcode == UNPACK_SEQUENCE &&
+           next->second.oparg == this->instructions[idx].oparg &&
+           getEdges(next->first).empty();
+}
+
+/* A call like math.sqrt(x) on an unboxed argument, which is compiled as a direct call to libm, see nativeMathFunction().
+ * Returns the function, or nullptr. The int results of floor() and ceil() are objects. */
+const NativeMathFunction* InstructionGraph::nativeMathCall(py_opindex idx) {
+    if (this->instructions[idx].opcode != CALL_METHOD || this->instructions[idx].oparg != 1)
+        return nullptr;
+    auto edgesIn = getEdges(idx);
+    if (edgesIn.size() != 3 || edgesIn[0].position != 0 || edgesIn[1].position != 1 || edgesIn[2].position != 2)
+        return nullptr;
+    auto method = dynamic_cast<MethodSource*>(edgesIn[1].source);
+    auto module = dynamic_cast<GlobalValue*>(edgesIn[2].value);
+    if (method == nullptr || module == nullptr || !supportsEscaping(edgesIn[0].kind))
+        return nullptr;
+    auto function = nativeMathFunction(module->lastValue(), method->name(), edgesIn[0].kind);
+    if (function == nullptr || function->returnsInt)
+        return function;
+    for (auto& edgeOut : getEdgesFrom(idx)) {
+        if (!supportsEscaping(edgeOut.kind))
+            return nullptr;
+    }
+    return function;
+}
+
+/* A list subscript by an unboxed int, which reads the item inline, see emit_list_index(). The list and the item stay objects. */
+bool InstructionGraph::canIndexList(py_opindex idx) {
+    auto edgesIn = getEdges(idx);
+    return edgesIn.size() == 2 && edgesIn[0].position == 0 && edgesIn[1].position == 1 &&
+           edgesIn[0].kind == AVK_Integer && edgesIn[1].kind == AVK_List;
+}
+
+/* The UNPACK_SEQUENCE of `for i, x in enumerate(...)`, which pushes the counter unboxed when it's stored to a local
+ * by the next instruction, see AbstractInterpreter::enumerateStep(). The item stays an object. */
+bool InstructionGraph::isEnumerateStep(py_opindex idx) {
+    if (this->instructions[idx].oparg != 2)
+        return false;
+    auto before = instructionsBefore(idx, 3);
+    if (before.size() != 3 || this->instructions[before[0]].opcode != CALL_FUNCTION ||
+        this->instructions[before[1]].opcode != GET_ITER || this->instructions[before[2]].opcode != FOR_ITER)
+        return false;
+    bool enumerate = false;
+    for (auto& edge : getEdges(before[0])) {
+        if (edge.position == this->instructions[before[0]].oparg)
+            enumerate = knownFunctionReturnType(AbstractValueWithSources(edge.value, edge.source)) == AVK_Enumerate;
+    }
+    auto next = this->instructions.find(idx + SIZEOF_CODEUNIT);
+    if (!enumerate || next == this->instructions.end() || next->second.opcode != STORE_FAST)
+        return false;
+    auto edgesOut = getEdgesFrom(idx);
+    if (edgesOut.size() != 2)
+        return false;
+    for (auto& edge : edgesOut) {
+        if (edge.to == next->first)
+            return edge.kind == AVK_Integer;
+    }
+    return false;
+}
+
+/* A call to len(), abs(), min(), max(), isinstance(), int(), float(), bool() or str() that is compiled inline, see inlineBuiltin(). */
+InlineBuiltin InstructionGraph::inlineBuiltinCall(py_opindex idx) {
+    auto oparg = this->instructions[idx].oparg;
+    if (this->instructions[idx].opcode != CALL_FUNCTION || oparg < 1 || oparg > 2)
+        return NoInlineBuiltin;
+    auto edgesIn = getEdges(idx);
+    if (edgesIn.size() != oparg + 1)
+        return NoInlineBuiltin;
+    vector<AbstractValueKind> args;
+    for (py_oparg i = oparg; i > 0; i--) {
+        if (edgesIn[i - 1].position != i - 1)
+            return NoInlineBuiltin;
+        args.push_back(edgesIn[i - 1].kind);
+    }
+    auto builtin = inlineBuiltin(edgesIn[oparg].source, args, oparg == 2 ? edgesIn[0].source : nullptr);
+    if (builtin == NoInlineBuiltin)
+        return NoInlineBuiltin;
+    if (inlineBuiltinUnboxesArgs(builtin)) {
+        for (auto& kind : args) {
+            if (!supportsEscaping(kind))
+                return NoInlineBuiltin;
+        }
+    }
+    if (inlineBuiltinBoxesResult(builtin))
+        return builtin;
+    for (auto& edgeOut : getEdgesFrom(idx)) {
+        if (!supportsEscaping(edgeOut.kind))
+            return NoInlineBuiltin;
+    }
+    return builtin;
+}
+
+/* A call to a Python function whose result is only used unboxed, see PyJit_CallDirect(). Returns the kind of the
+ * result, or AVK_Any if the call can't be made directly. */
+AbstractValueKind InstructionGraph::directCallKind(py_opindex idx) {
+    auto oparg = this->instructions[idx].oparg;
+    auto edgesIn = getEdges(idx);
+    if (edgesIn.size() != oparg + 1)
+        return AVK_Any;
+    for (py_oparg i = 0; i <= oparg; i++) {
+        if (edgesIn[i].position != i)
+            return AVK_Any;
+    }
+    auto function = dynamic_cast<GlobalValue*>(edgesIn[oparg].value);
+    if (function == nullptr || !supportsDirectCall(function->lastValue(), oparg))
+        return AVK_Any;
+    auto edgesOut = getEdgesFrom(idx);
+    if (edgesOut.empty())
+        return AVK_Any;
+    auto kind = edgesOut[0].kind;
+    if (kind != AVK_Integer && kind != AVK_Float)
+        return AVK_Any;
+    for (auto& edgeOut : edgesOut) {
+        if (edgeOut.kind != kind)
+            return AVK_Any;
+    }
+    return kind;
+}
+
+/* The kinds a direct call passes its arguments as, in call order. An argument is passed unboxed when the compiled direct
+ * variant of the function takes it unboxed as the kind it has here, otherwise it's AVK_Any. */
+vector<AbstractValueKind> InstructionGraph::directCallArgKinds(py_opindex idx) {
+    auto oparg = this->instructions[idx].oparg;
+    auto edgesIn = getEdges(idx);
+    auto function = dynamic_cast<GlobalValue*>(edgesIn[oparg].value)->lastValue();
+    vector<AbstractValueKind> kinds(oparg, AVK_Any);
+    for (py_oparg i = 0; i < oparg; i++) {
+        auto kind = PyJit_DirectArgKind(function, i);
+        if (kind != AVK_Any && edgesIn[oparg - 1 - i].kind == kind)
+            kinds[i] = kind;
+    }
+    return kinds;
+}
+
+/* The return of an unboxed int or float from the direct variant of a function */
+bool InstructionGraph::isUnboxedReturn(py_opindex idx) {
+    if (!directVariant)
+        return false;
+    auto edgesIn = getEdges(idx);
+    return edgesIn.size() == 1 && (edgesIn[0].kind == AVK_Integer || edgesIn[0].kind == AVK_Float);
+}
+
+/* Inputs of an escaped op that stay objects: the method and self of a native math call, the function of an inlined
+ * builtin, the arguments of len() and isinstance() and the list of a list index. */
+bool InstructionGraph::isBoxedInput(const Edge& edge) {
+    auto& to = this->instructions[edge.to];
+    switch (to.opcode) {
+        case BINARY_SUBSCR:
+            return edge.position == 1 && isListIndex(edge.to);
+        case CALL_METHOD:
+            return edge.position > 0;
+        case UNPACK_SEQUENCE:
+            return true;
+        case CALL_FUNCTION:
+            if (edge.position == to.oparg)
+                return true;
+            if (getDirectCallKind(edge.to) != AVK_Any)
+                return directCallArgs[edge.to][to.oparg - 1 - edge.position] == AVK_Any;
+            return !inlineBuiltinUnboxesArgs(getInlineBuiltin(edge.to));
+        default:
+            return false;
+    }
+}
+
+/* The result of an escaped op that is an object: the string from str(), the int from int() of a float or from
+ * math.floor() and math.ceil(), the item of a list index and the item of an enumerate() step */
+bool InstructionGraph::isBoxedOutput(const Edge& edge) {
+    auto& from = this->instructions[edge.from];
+    if (from.opcode == BINARY_SUBSCR)
+        return isListIndex(edge.from);
+    if (from.opcode == UNPACK_SEQUENCE)
+        return edge.to != edge.from + SIZEOF_CODEUNIT;
+    if (from.opcode == CALL_METHOD)
+        return nativeMathIntCalls.find(edge.from) != nativeMathIntCalls.end();
+    return from.opcode == CALL_FUNCTION && inlineBuiltinBoxesResult(getInlineBuiltin(edge.from));
+}
+
+InlineBuiltin InstructionGraph::getInlineBuiltin(py_opindex i) {
+    auto builtin = inlineBuiltins.find(i);
+    return builtin == inlineBuiltins.end() ? NoInlineBuiltin : builtin->second;
+}
+
+AbstractValueKind InstructionGraph::getDirectCallKind(py_opindex i) {
+    auto kind = directCalls.find(i);
+    return kind == directCalls.end() ? AVK_Any : kind->second;
+}
+
+vector<AbstractValueKind> InstructionGraph::getDirectCallArgKinds(py_opindex i) {
+    return directCallArgs[i];
+}
+
+bool InstructionGraph::isLoopBound(py_opindex i) {
+    return loopBounds.find(i) != loopBounds.end();
+}
+
+py_opindex InstructionGraph::getLoopBoundEntry(py_opindex i) {
+    return loopBounds[i];
+}
+
+bool InstructionGraph::isListIndex(py_opindex i) {
+    return listIndexes.find(i) != listIndexes.end();
+}
+
+bool InstructionGraph::isRangeListLoop(py_opindex i) {
+    return rangeListLoops.find(i) != rangeListLoops.end();
+}
+
+vector<py_oparg> InstructionGraph::getRangeListLoopLists(py_opindex i) {
+    return rangeListLoops[i];
+}
+
+bool InstructionGraph::isInBoundsIndex(py_opindex i) {
+    return inBoundsIndexes.find(i) != inBoundsIndexes.end();
+}
+
+py_opindex InstructionGraph::getInBoundsLoop(py_opindex i) {
+    return inBoundsIndexes[i];
+}
+
 void InstructionGraph::fixLocals(py_oparg startIdx, py_oparg endIdx) {
     for (py_oparg localNumber = startIdx; localNumber <= endIdx; localNumber++) {
         // get all LOAD_FAST instructions
@@ -258,7 +530,11 @@ void InstructionGraph::fixLocals(py_oparg startIdx, py_oparg endIdx) {
                 }
             }
         }
-        if (loadsCanBeEscaped && storesCanBeEscaped && hasStores && hasLoads && abstractTypesMatch) {
+        // Arguments are passed to the direct variant in a PyjionDirectCall, which only holds ints and floats
+        bool isArgument = localNumber < code->co_argcount;
+        if (isArgument && localAvk != AVK_Integer && localAvk != AVK_Float)
+            continue;
+        if (loadsCanBeEscaped && storesCanBeEscaped && (hasStores || isArgument) && hasLoads && abstractTypesMatch) {
             unboxedFastLocals.insert({localNumber, localAvk});
             for (auto& instruction : this->instructions) {
                 if (instruction.second.opcode == LOAD_FAST && instruction.second.oparg == localNumber) {
@@ -275,6 +551,170 @@ void InstructionGraph::fixLocals(py_oparg startIdx, py_oparg endIdx) {
     }
 }
 
+/* The indexes of the count instructions before idx, skipping EXTENDED_ARG, or fewer at the start of the code */
+vector<py_opindex> InstructionGraph::instructionsBefore(py_opindex idx, size_t count) {
+    vector<py_opindex> result;
+    auto it = this->instructions.find(idx);
+    while (it != this->instructions.begin() && result.size() < count) {
+        --it;
+        if (it->second.opcode != EXTENDED_ARG)
+            result.insert(result.begin(), it->first);
+    }
+    return result;
+}
+
+/* A counted while loop is compiled by CPython with its condition checked at the top and again at the bottom:
+ *
+ *   top:    LOAD_FAST i, LOAD_FAST n, COMPARE_OP, POP_JUMP_IF_FALSE exit
+ *   body:   ... STORE_FAST i ...
+ *   bottom: LOAD_FAST i, LOAD_FAST n, COMPARE_OP, POP_JUMP_IF_TRUE body
+ *   exit:
+ *
+ * When i is an unboxed int local and the bound n is an int local which isn't unboxed and isn't stored to in the loop,
+ * n is unboxed once by the check at the top and the check at the bottom reuses that value instead of unboxing n on
+ * every iteration. */
+void InstructionGraph::fixLoopBounds() {
+    for (auto it = this->instructions.begin(); it != this->instructions.end(); ++it) {
+        auto& bottomJump = it->second;
+        if (bottomJump.opcode != POP_JUMP_IF_TRUE || bottomJump.jumpsTo >= bottomJump.index || next(it) == this->instructions.end())
+            continue;
+        auto bottom = instructionsBefore(bottomJump.index, 3);
+        auto topJump = instructionsBefore(bottomJump.jumpsTo, 1);
+        if (bottom.size() != 3 || topJump.size() != 1)
+            continue;
+        auto top = instructionsBefore(topJump[0], 3);
+        if (top.size() != 3 || this->instructions[topJump[0]].opcode != POP_JUMP_IF_FALSE ||
+            this->instructions[topJump[0]].jumpsTo != next(it)->first)
+            continue;
+        bool matches = true;
+        for (size_t i = 0; i < 3; i++) {
+            auto& topInstruction = this->instructions[top[i]];
+            auto& bottomInstruction = this->instructions[bottom[i]];
+            if (topInstruction.opcode != (i < 2 ? LOAD_FAST : COMPARE_OP) || topInstruction.opcode != bottomInstruction.opcode ||
+                topInstruction.oparg != bottomInstruction.oparg)
+                matches = false;
+        }
+        if (!matches || !this->instructions[top[2]].escape || !this->instructions[bottom[2]].escape)
+            continue;
+
+        // Either side of the comparison can be the bound
+        auto isInduction = [&](py_oparg local) {
+            auto unboxed = unboxedFastLocals.find(local);
+            if (unboxed == unboxedFastLocals.end() || unboxed->second != AVK_Integer)
+                return false;
+            for (auto store = this->instructions.find(bottomJump.jumpsTo); store->first < bottom[0]; ++store) {
+                if (store->second.opcode == STORE_FAST && store->second.oparg == local)
+                    return true;
+            }
+            return false;
+        };
+        size_t boundSide;
+        if (isInduction(this->instructions[top[0]].oparg))
+            boundSide = 1;
+        else if (isInduction(this->instructions[top[1]].oparg))
+            boundSide = 0;
+        else
+            continue;
+        auto bound = this->instructions[top[boundSide]].oparg;
+        if (bound == this->instructions[top[1 - boundSide]].oparg || unboxedFastLocals.find(bound) != unboxedFastLocals.end())
+            continue;
+        for (auto store = this->instructions.find(top[0]); store->first < bottomJump.index; ++store) {
+            if ((store->second.opcode == STORE_FAST || store->second.opcode == DELETE_FAST) && store->second.oparg == bound)
+                matches = false;
+        }
+        for (auto load : {top[boundSide], bottom[boundSide]}) {
+            auto loadEdges = getEdgesFrom(load);
+            if (loadEdges.size() != 1 || loadEdges[0].kind != AVK_Integer)
+                matches = false;
+        }
+        if (!matches)
+            continue;
+        loopBounds[top[boundSide]] = top[boundSide];
+        loopBounds[bottom[boundSide]] = top[boundSide];
+        this->instructions[top[boundSide]].escape = true;
+        this->instructions[bottom[boundSide]].escape = true;
+    }
+}
+
+/* Range loops like for i in range(len(xs)) whose body indexes lists held in locals. A body that only does unboxed
+ * arithmetic, indexes lists and doesn't store to the index or the lists can't resize them, so once a guard at the top of
+ * the loop has checked that every value of the range is in range of each list, the bounds checks of xs[i] can be
+ * dropped, see PyJit_RangeIndexesList(). Pending calls at the back edges can run signal handlers, which clear the guard
+ * when they run. */
+void InstructionGraph::fixRangeListLoops() {
+    for (auto it = this->instructions.begin(); it != this->instructions.end(); ++it) {
+        if (it->second.opcode != GET_ITER || !it->second.escape)
+            continue;
+        auto forIter = next(it);
+        if (forIter == this->instructions.end() || forIter->second.opcode != FOR_ITER || !forIter->second.escape)
+            continue;
+        auto storeIndex = next(forIter);
+        if (storeIndex == this->instructions.end() || storeIndex->second.opcode != STORE_FAST || !storeIndex->second.escape)
+            continue;
+        auto index = storeIndex->second.oparg;
+        auto unboxed = unboxedFastLocals.find(index);
+        if (unboxed == unboxedFastLocals.end() || unboxed->second != AVK_Integer)
+            continue;
+
+        bool matches = true;
+        vector<py_oparg> lists;
+        vector<py_opindex> inBounds;
+        for (auto body = next(storeIndex); matches && body != this->instructions.end() && body->first < forIter->second.jumpsTo; ++body) {
+            auto& instruction = body->second;
+            switch (instruction.opcode) {
+                case LOAD_FAST:
+                case LOAD_CONST:
+                case NOP:
+                case EXTENDED_ARG:
+                case JUMP_ABSOLUTE:
+                case JUMP_FORWARD:
+                    break;
+                case STORE_FAST:
+                case DELETE_FAST:
+                    // Stores of objects can release the last reference to something with a __del__
+                    matches = instruction.escape && instruction.oparg != index;
+                    break;
+                case POP_JUMP_IF_FALSE:
+                case POP_JUMP_IF_TRUE: {
+                    auto edgesIn = getEdges(body->first);
+                    matches = edgesIn.size() == 1 && edgesIn[0].kind == AVK_Bool;
+                    break;
+                }
+                case CALL_FUNCTION:
+                case CALL_METHOD:
+                    matches = false;
+                    break;
+                case BINARY_SUBSCR:
+                    if (instruction.escape && isListIndex(body->first)) {
+                        // Each list is checked by the guard, which also makes sure it's exact
+                        auto edgesIn = getEdges(body->first);
+                        auto container = this->instructions.find(edgesIn[1].from);
+                        auto key = this->instructions.find(edgesIn[0].from);
+                        if (container == this->instructions.end() || container->second.opcode != LOAD_FAST) {
+                            matches = false;
+                            break;
+                        }
+                        if (find(lists.begin(), lists.end(), container->second.oparg) == lists.end())
+                            lists.push_back(container->second.oparg);
+                        if (key != this->instructions.end() && key->second.opcode == LOAD_FAST && key->second.oparg == index)
+                            inBounds.push_back(body->first);
+                        break;
+                    }
+                    matches = instruction.escape;
+                    break;
+                default:
+                    matches = instruction.escape;
+                    break;
+            }
+        }
+        if (!matches || inBounds.empty())
+            continue;
+        rangeListLoops[it->first] = lists;
+        for (auto& subscr : inBounds)
+            inBoundsIndexes[subscr] = it->first;
+    }
+}
+
 PyObject* InstructionGraph::makeGraph(const char* name) {
     if (PyErr_Occurred()) {
 #ifdef DEBUG_VERBOSE
@@ -28,9 +28,11 @@
 #include <vector>
 #include <Python.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <map>
 #include "absvalue.h"
 #include "types.h"
+#include "unboxing.h"
 
 using namespace std;
 
@@ -102,20 +104,52 @@ private:
     bool invalid = false;
     map<py_opindex, Instruction> instructions;
     unordered_map<py_oparg, AbstractValueKind> unboxedFastLocals;
+    unordered_map<py_opindex, InlineBuiltin> inlineBuiltins;
+    unordered_map<py_opindex, AbstractValueKind> directCalls;
+    unordered_map<py_opindex, vector<AbstractValueKind>> directCallArgs;
+    unordered_map<py_opindex, py_opindex> loopBounds;// Bound loads of counted while loops to the load at the top of the loop
+    unordered_set<py_opindex> listIndexes;
+    unordered_set<py_opindex> nativeMathIntCalls;
+    unordered_map<py_opindex, vector<py_oparg>> rangeListLoops;// GET_ITER of range loops to the lists their body indexes
+    unordered_map<py_opindex, py_opindex> inBoundsIndexes;     // List indexes by the loop index to the GET_ITER of the loop
+    bool directVariant;
     vector<Edge> edges;
     void fixEdges();
     void fixInstructions();
     void deoptimizeInstructions();
     void fixLocals(py_oparg startIdx, py_oparg endIdx);
+    void fixLoopBounds();
+    void fixRangeListLoops();
+    vector<py_opindex> instructionsBefore(py_opindex idx, size_t count);
+    bool isUnpackedTuple(py_opindex idx);
+    const NativeMathFunction* nativeMathCall(py_opindex idx);
+    bool canIndexList(py_opindex idx);
+    bool isEnumerateStep(py_opindex idx);
+    InlineBuiltin inlineBuiltinCall(py_opindex idx);
+    bool isBoxedInput(const Edge& edge);
+    bool isBoxedOutput(const Edge& edge);
+    AbstractValueKind directCallKind(py_opindex idx);
+    vector<AbstractValueKind> directCallArgKinds(py_opindex idx);
+    bool isUnboxedReturn(py_opindex idx);
 
 public:
-    InstructionGraph(PyCodeObject* code, unordered_map<py_opindex, const InterpreterStack*> stacks, bool escapeLocals);
+    InstructionGraph(PyCodeObject* code, unordered_map<py_opindex, const InterpreterStack*> stacks, bool escapeLocals, bool directVariant = false);
     Instruction& operator[](py_opindex i) { return instructions[i]; }
     size_t size() { return instructions.size(); }
     PyObject* makeGraph(const char* name);
     vector<Edge> getEdges(py_opindex i);
     vector<Edge> getEdgesFrom(py_opindex i);
     unordered_map<py_oparg, AbstractValueKind> getUnboxedFastLocals();
+    InlineBuiltin getInlineBuiltin(py_opindex i);
+    AbstractValueKind getDirectCallKind(py_opindex i);
+    vector<AbstractValueKind> getDirectCallArgKinds(py_opindex i);
+    bool isLoopBound(py_opindex i);
+    py_opindex getLoopBoundEntry(py_opindex i);
+    bool isListIndex(py_opindex i);
+    bool isRangeListLoop(py_opindex i);
+    vector<py_oparg> getRangeListLoopLists(py_opindex i);
+    bool isInBoundsIndex(py_opindex i);
+    py_opindex getInBoundsLoop(py_opindex i);
     bool isValid() const;
 };
 
@@ -34,8 +34,6 @@ using namespace msl::utilities;
 
 #endif
 
-PyObject* g_emptyTuple;
-
 #include <dictobject.h>
 #include <vector>
 
@@ -218,6 +216,52 @@ PyObject* PyJit_SubscrListIndex(PyObject* o, PyObject* key, Py_ssize_t index) {
     return res;
 }
 
+PyObject* PyJit_SubscrListUnboxedIndex(PyObject* o, int64_t index) {
+    PyObject* res;
+    if (PyList_CheckExact(o)) {
+        if (index < 0)
+            index += Py_SIZE(o);
+        if (index < 0 || index >= Py_SIZE(o)) {
+            PyErr_SetString(PyExc_IndexError, "list index out of range");
+            res = nullptr;
+        } else {
+            res = PyList_GET_ITEM(o, index);
+            Py_INCREF(res);
+        }
+    } else {
+        auto key = PyLong_FromLongLong(index);
+        res = key == nullptr ? nullptr : PyObject_GetItem(o, key);
+        Py_XDECREF(key);
+    }
+    Py_DECREF(o);
+    return res;
+}
+
+int32_t PyJit_RangeIndexesList(PyObject* range, PyObject* list) {
+    if (!PyRange_Check(range) || list == nullptr || !PyList_CheckExact(list))
+        return 0;
+    auto* r = (py_rangeobject*) range;
+    int overflow = 0;
+    int64_t start = PyLong_AsLongLongAndOverflow(r->start, &overflow);
+    if (overflow)
+        return 0;
+    int64_t step = PyLong_AsLongLongAndOverflow(r->step, &overflow);
+    if (overflow)
+        return 0;
+    int64_t length = PyLong_AsLongLongAndOverflow(r->length, &overflow);
+    if (overflow)
+        return 0;
+    if (length == 0)
+        return 1;
+    Py_ssize_t size = Py_SIZE(list);
+    if (start < 0 || start >= size)
+        return 0;
+    // The last value, start + (length - 1) * step, must be in range as well
+    if (step > 0)
+        return (length - 1) <= (size - 1 - start) / step;
+    return (length - 1) <= start / -step;
+}
+
 PyObject* PyJit_SubscrListSliceStepped(PyObject* o, Py_ssize_t start, Py_ssize_t stop, Py_ssize_t step) {
     Py_ssize_t slicelength, i;
     size_t cur;
@@ -466,6 +510,52 @@ PyObject* PyJit_ListAppend(PyObject* list, PyObject* value) {
     return list;
 }
 
+// Number of items left in the iterator a comprehension was called with, if it's over a list, tuple or range
+static Py_ssize_t PyJit_ComprehensionLength(PyFrameObject* frame) {
+    auto iter = frame->f_localsplus[0];
+    if (iter == nullptr ||
+        (Py_TYPE(iter) != &PyListIter_Type && Py_TYPE(iter) != &PyTupleIter_Type && Py_TYPE(iter) != &PyRangeIter_Type))
+        return 0;
+    auto hint = PyObject_LengthHint(iter, 0);
+    if (hint < 0) {
+        PyErr_Clear();
+        return 0;
+    }
+    return hint;
+}
+
+// Largest number of items a comprehension list is presized for, longer lists grow from there as they're filled in
+#define MAX_COMPREHENSION_PRESIZE (1 << 16)
+
+PyObject* PyJit_NewComprehensionList(PyFrameObject* frame) {
+    auto length = PyJit_ComprehensionLength(frame);
+    auto list = PyList_New(length > MAX_COMPREHENSION_PRESIZE ? MAX_COMPREHENSION_PRESIZE : length);
+    // The items are allocated but the list starts empty, LIST_APPEND fills them in without resizing up to the presize
+    if (list != nullptr)
+        Py_SET_SIZE(list, 0);
+    return list;
+}
+
+PyObject* PyJit_NewComprehensionDict(PyFrameObject* frame) {
+    return _PyDict_NewPresized(PyJit_ComprehensionLength(frame));
+}
+
+PyObject* PyJit_TrimList(PyObject* list) {
+    // Same threshold as list_resize(), a comprehension with a condition can leave most of the presized room unused
+    if (!PyList_CheckExact(list))
+        return list;
+    auto self = (PyListObject*) list;
+    auto size = Py_SIZE(self);
+    if (size >= (self->allocated >> 1))
+        return list;
+    auto items = (PyObject**) PyMem_Realloc(self->ob_item, size * sizeof(PyObject*));
+    if (items != nullptr) {
+        self->ob_item = items;
+        self->allocated = size;
+    }
+    return list;
+}
+
 PyObject* PyJit_SetAdd(PyObject* set, PyObject* value) {
     ASSERT_ARG(set);
     int err;
@@ -689,6 +779,203 @@ PyObject* PyJit_InplaceOr(PyObject* left, PyObject* right) {
     return res;
 }
 
+/* Reads an operand of complex arithmetic, following complex's own conversion of float and int operands.
+ * Returns 1 on success, 0 for types handled by the generic number protocol and -1 on error. */
+static int PyJit_ComplexOperand(PyObject* obj, Py_complex* value) {
+    if (PyComplex_CheckExact(obj)) {
+        *value = ((PyComplexObject*) obj)->cval;
+        return 1;
+    }
+    value->imag = 0.0;
+    if (PyFloat_CheckExact(obj)) {
+        value->real = PyFloat_AS_DOUBLE(obj);
+        return 1;
+    }
+    if (PyLong_CheckExact(obj) || PyBool_Check(obj)) {
+        value->real = PyLong_AsDouble(obj);
+        if (value->real == -1.0 && PyErr_Occurred())
+            return -1;
+        return 1;
+    }
+    return 0;
+}
+
+PyObject* PyJit_ComplexBinaryOp(PyObject* left, PyObject* right, int32_t opcode) {
+    Py_complex a, b, result;
+    int status = 0;
+    if (PyComplex_CheckExact(left) || PyComplex_CheckExact(right)) {
+        status = PyJit_ComplexOperand(left, &a);
+        if (status == 1)
+            status = PyJit_ComplexOperand(right, &b);
+    }
+    if (status == -1) {
+        Py_DECREF(left);
+        Py_DECREF(right);
+        return nullptr;
+    }
+    if (status == 0) {
+        switch (opcode) {
+            case BINARY_ADD:
+                return PyJit_Add(left, right);
+            case INPLACE_ADD:
+                return PyJit_InplaceAdd(left, right);
+            case BINARY_SUBTRACT:
+                return PyJit_Subtract(left, right);
+            case INPLACE_SUBTRACT:
+                return PyJit_InplaceSubtract(left, right);
+            case BINARY_MULTIPLY:
+                return PyJit_Multiply(left, right);
+            case INPLACE_MULTIPLY:
+                return PyJit_InplaceMultiply(left, right);
+            case BINARY_TRUE_DIVIDE:
+                return PyJit_TrueDivide(left, right);
+            default:
+                return PyJit_InplaceTrueDivide(left, right);
+        }
+    }
+
+    switch (opcode) {
+        case BINARY_ADD:
+        case INPLACE_ADD:
+            result = _Py_c_sum(a, b);
+            break;
+        case BINARY_SUBTRACT:
+        case INPLACE_SUBTRACT:
+            result = _Py_c_diff(a, b);
+            break;
+        case BINARY_MULTIPLY:
+        case INPLACE_MULTIPLY:
+            result = _Py_c_prod(a, b);
+            break;
+        default:
+            errno = 0;
+            result = _Py_c_quot(a, b);
+            if (errno == EDOM) {
+                PyErr_SetString(PyExc_ZeroDivisionError, "complex division by zero");
+                Py_DECREF(left);
+                Py_DECREF(right);
+                return nullptr;
+            }
+    }
+
+    // An operand only referenced from the stack is a temporary nobody else can observe, reuse it for the result
+    if (PyComplex_CheckExact(left) && Py_REFCNT(left) == 1) {
+        ((PyComplexObject*) left)->cval = result;
+        Py_DECREF(right);
+        return left;
+    }
+    if (PyComplex_CheckExact(right) && Py_REFCNT(right) == 1) {
+        ((PyComplexObject*) right)->cval = result;
+        Py_DECREF(left);
+        return right;
+    }
+    Py_DECREF(left);
+    Py_DECREF(right);
+    return PyComplex_FromCComplex(result);
+}
+
+PyObject* PyJit_LoadComplexPart(PyObject* obj, PyObject* name, int32_t imag) {
+    PyObject* res;
+    if (PyComplex_CheckExact(obj)) {
+        res = PyFloat_FromDouble(imag ? ((PyComplexObject*) obj)->cval.imag : ((PyComplexObject*) obj)->cval.real);
+    } else {
+        res = PyObject_GetAttr(obj, name);
+    }
+    Py_DECREF(obj);
+    return res;
+}
+
+/* Checks that a method loaded from the math module is still the builtin a native call was compiled for, releasing
+ * the method and its location (as MethCall1 does) when it is. */
+int32_t PyJit_CheckMathMethod(PyJitMethodLocation* method_info, PyMethodDef* def) {
+    auto method = method_info->method;
+    if (method == nullptr || method_info->object != nullptr || !PyCFunction_CheckExact(method) ||
+        ((PyCFunctionObject*) method)->m_ml != def)
+        return 0;
+    Py_DECREF(method);
+    Py_DECREF(method_info);
+    return 1;
+}
+
+/* Raises the error the math module would for function(x) == result, as math_1() does. Returns 1 if an error was set. */
+int32_t PyJit_MathError(double x, double result, const NativeMathFunction* function) {
+    if (Py_IS_NAN(result)) {
+        if (Py_IS_NAN(x))
+            return 0;
+        PyErr_SetString(PyExc_ValueError, "math domain error");
+        return 1;
+    }
+    if (Py_IS_INFINITY(result) && Py_IS_FINITE(x)) {
+        if (function->canOverflow)
+            PyErr_SetString(PyExc_OverflowError, "math range error");
+        else
+            PyErr_SetString(PyExc_ValueError, "math domain error");
+        return 1;
+    }
+    return 0;
+}
+
+/* Fills the interpreter's small int table from its cached ints, which the table keeps a reference to. */
+bool PyJit_InitBoxing(PyjionInterpreterState* state) {
+    state->emptyTuple = PyTuple_New(0);
+    if (state->emptyTuple == nullptr)
+        return false;
+    for (long i = PYJIT_SMALL_INT_MIN; i < PYJIT_SMALL_INT_MAX; i++) {
+        state->smallInts[i - PYJIT_SMALL_INT_MIN] = PyLong_FromLong(i);
+        if (state->smallInts[i - PYJIT_SMALL_INT_MIN] == nullptr)
+            return false;
+    }
+    state->floatFreeList.count = 0;
+    return true;
+}
+
+/* Releases the interpreter's boxing tables when it is finalized. */
+void PyJit_FreeBoxing(PyjionInterpreterState* state) {
+    Py_CLEAR(state->emptyTuple);
+    for (auto& smallInt : state->smallInts)
+        Py_CLEAR(smallInt);
+    while (state->floatFreeList.count > 0)
+        PyObject_Free(state->floatFreeList.items[--state->floatFreeList.count]);
+}
+
+/* Boxes a float when the interpreter's freelist is empty, refilling it first. The objects are allocated individually
+ * so they can be released by float's own dealloc. */
+PyObject* PyJit_FloatFromDouble(double value) {
+    auto& freeList = PyJit_InterpreterState()->floatFreeList;
+    while (freeList.count < PYJIT_FLOAT_FREELIST_SIZE) {
+        auto item = (PyObject*) PyObject_Malloc(sizeof(PyFloatObject));
+        if (item == nullptr)
+            break;
+        freeList.items[freeList.count++] = item;
+    }
+    if (freeList.count == 0)
+        return PyFloat_FromDouble(value);
+    auto result = (PyFloatObject*) freeList.items[--freeList.count];
+    PyObject_Init((PyObject*) result, &PyFloat_Type);
+    result->ob_fval = value;
+    return (PyObject*) result;
+}
+
+/* str() of an unboxed int, written straight into a new ASCII string without creating the int object. */
+PyObject* PyJit_UnboxedIntToString(int64_t value) {
+    char buffer[21];
+    char* end = buffer + sizeof(buffer);
+    char* start = end;
+    // Negate as unsigned so INT64_MIN doesn't overflow
+    uint64_t remaining = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+    do {
+        *--start = (char) ('0' + remaining % 10);
+        remaining /= 10;
+    } while (remaining != 0);
+    if (value < 0)
+        *--start = '-';
+    auto result = PyUnicode_New(end - start, 127);
+    if (result == nullptr)
+        return nullptr;
+    memcpy(PyUnicode_1BYTE_DATA(result), start, end - start);
+    return result;
+}
+
 int PyJit_PrintExpr(PyObject* value) {
     _Py_IDENTIFIER(displayhook);
     PyObject* hook = _PySys_GetObjectId(&PyId_displayhook);
@@ -1694,6 +1981,266 @@ PyObject* PyJit_IterNextUnboxed(PyObject* iter) {
     }
 }
 
+PyObject* PyJit_UnpackIterNew(PyObject* callable, PyObject* args, int32_t width, int32_t unboxedCounter) {
+    auto res = PyjionUnpackIter_FromCall(callable, args, width, unboxedCounter != 0);
+    if (res == nullptr && !PyErr_Occurred()) {
+        // Not enumerate() or zip() over sequences (e.g. the builtin was rebound), make the call as written
+        res = PyObject_Call(callable, args, nullptr);
+    }
+    Py_DECREF(callable);
+    Py_DECREF(args);
+    return res;
+}
+
+PyObject* PyJit_GetUnpackIter(PyObject* iterable, int32_t width) {
+    auto res = PyjionUnpackIter_FromIterable(iterable, width);
+    if (res == nullptr && !PyErr_Occurred())
+        res = PyObject_GetIter(iterable);
+    Py_DECREF(iterable);
+    return res;
+}
+
+PyObject* PyJit_UnpackIterNext(PyObject* iter) {
+    if (!PyjionUnpackIter_Check(iter))
+        return PyJit_IterNext(iter);
+    auto it = (pyjion_unpackiterobject*) iter;
+    switch (PyjionUnpackIter_Advance(it)) {
+        case 1:
+            if (PyjionUnpackIter_IsDirect(it)) {
+                auto item = it->items[0];
+                it->items[0] = nullptr;
+                return item;
+            }
+            // The iterator stands in for the tuple, UNPACK_SEQUENCE takes the items out of it
+            Py_INCREF(iter);
+            return iter;
+        case 0:
+            return (PyObject*) SIG_STOP_ITER;
+        default:
+            return (PyObject*) SIG_ITER_ERROR;
+    }
+}
+
+// Looks up the C functions behind the interpreter's sum(), any(), all(), min() and max(), so a call can be matched
+// to the builtin by identity
+bool PyJit_InitConsumers(PyjionInterpreterState* state) {
+    const char* names[] = {"sum", "any", "all", "min", "max"};
+    state->consumerFunctions.assign(ConsumeMax + 1, nullptr);
+    auto builtins = PyImport_ImportModule("builtins");
+    if (builtins == nullptr)
+        return false;
+    for (int kind = ConsumeSum; kind <= ConsumeMax; kind++) {
+        auto function = PyObject_GetAttrString(builtins, names[kind]);
+        if (function == nullptr) {
+            Py_DECREF(builtins);
+            return false;
+        }
+        if (PyCFunction_Check(function))
+            state->consumerFunctions[kind] = PyCFunction_GET_FUNCTION(function);
+        Py_DECREF(function);
+    }
+    Py_DECREF(builtins);
+    return true;
+}
+
+static bool PyJit_IsConsumer(PyObject* callable, PyjionConsumerKind kind) {
+    switch (kind) {
+        case ConsumeList:
+            return callable == (PyObject*) &PyList_Type;
+        case ConsumeTuple:
+            return callable == (PyObject*) &PyTuple_Type;
+        case ConsumeSet:
+            return callable == (PyObject*) &PySet_Type;
+        default: {
+            auto& functions = PyJit_InterpreterState()->consumerFunctions;
+            return (size_t) kind < functions.size() && PyCFunction_Check(callable) &&
+                   PyCFunction_GET_FUNCTION(callable) == functions[kind];
+        }
+    }
+}
+
+static int32_t PyJit_SumAccept(PyjionConsumer* consumer, PyObject* value) {
+    int overflow;
+    switch (consumer->phase) {
+        case SumInts:
+            if (PyLong_CheckExact(value) || PyBool_Check(value)) {
+                long b = PyLong_AsLongAndOverflow(value, &overflow);
+                if (overflow == 0 &&
+                    (consumer->intTotal >= 0 ? (b <= LONG_MAX - consumer->intTotal) : (b >= LONG_MIN - consumer->intTotal))) {
+                    consumer->intTotal += b;
+                    Py_DECREF(value);
+                    return 0;
+                }
+            }
+            // Either overflowed or not an int, carry on with a boxed total
+            consumer->result = PyLong_FromLong(consumer->intTotal);
+            break;
+        case SumFloats:
+            if (PyFloat_CheckExact(value)) {
+                consumer->floatTotal += PyFloat_AS_DOUBLE(value);
+                Py_DECREF(value);
+                return 0;
+            }
+            if (PyLong_Check(value)) {
+                long b = PyLong_AsLongAndOverflow(value, &overflow);
+                if (!overflow) {
+                    consumer->floatTotal += (double) b;
+                    Py_DECREF(value);
+                    return 0;
+                }
+            }
+            consumer->result = PyFloat_FromDouble(consumer->floatTotal);
+            break;
+        case SumObjects:
+            break;
+    }
+    if (consumer->result == nullptr) {
+        Py_DECREF(value);
+        return -1;
+    }
+    auto total = PyNumber_Add(consumer->result, value);
+    Py_DECREF(value);
+    Py_SETREF(consumer->result, total);
+    if (total == nullptr)
+        return -1;
+    if (consumer->phase == SumInts && PyFloat_CheckExact(total)) {
+        consumer->phase = SumFloats;
+        consumer->floatTotal = PyFloat_AS_DOUBLE(total);
+        Py_CLEAR(consumer->result);
+    } else {
+        consumer->phase = SumObjects;
+    }
+    return 0;
+}
+
+int32_t PyJit_ConsumerAccept(PyjionConsumer* consumer, PyObject* value) {
+    int res;
+    switch (consumer->kind) {
+        case ConsumeSum:
+            return PyJit_SumAccept(consumer, value);
+        case ConsumeAny:
+        case ConsumeAll:
+            res = PyObject_IsTrue(value);
+            Py_DECREF(value);
+            if (res < 0)
+                return -1;
+            if (res == (consumer->kind == ConsumeAny)) {
+                consumer->result = Py_NewRef(res ? Py_True : Py_False);
+                return 1;
+            }
+            return 0;
+        case ConsumeMin:
+        case ConsumeMax:
+            if (consumer->result == nullptr) {
+                consumer->result = value;
+                return 0;
+            }
+            if (PyFloat_CheckExact(value) && PyFloat_CheckExact(consumer->result)) {
+                double item = PyFloat_AS_DOUBLE(value), current = PyFloat_AS_DOUBLE(consumer->result);
+                res = consumer->kind == ConsumeMin ? item < current : item > current;
+            } else {
+                res = PyObject_RichCompareBool(value, consumer->result, consumer->kind == ConsumeMin ? Py_LT : Py_GT);
+                if (res < 0) {
+                    Py_DECREF(value);
+                    return -1;
+                }
+            }
+            if (res > 0) {
+                Py_SETREF(consumer->result, value);
+            } else {
+                Py_DECREF(value);
+            }
+            return 0;
+        case ConsumeList:
+        case ConsumeTuple:
+            res = PyList_Append(consumer->result, value);
+            Py_DECREF(value);
+            return res;
+        case ConsumeSet:
+            res = PySet_Add(consumer->result, value);
+            Py_DECREF(value);
+            return res;
+    }
+    Py_DECREF(value);
+    return -1;
+}
+
+static PyObject* PyJit_ConsumerFinish(PyjionConsumer* consumer) {
+    switch (consumer->kind) {
+        case ConsumeSum:
+            if (consumer->phase == SumInts)
+                return PyLong_FromLong(consumer->intTotal);
+            if (consumer->phase == SumFloats)
+                return PyFloat_FromDouble(consumer->floatTotal);
+            return consumer->result;
+        case ConsumeAny:
+            return consumer->result != nullptr ? consumer->result : Py_NewRef(Py_False);
+        case ConsumeAll:
+            return consumer->result != nullptr ? consumer->result : Py_NewRef(Py_True);
+        case ConsumeMin:
+        case ConsumeMax:
+            if (consumer->result == nullptr)
+                PyErr_Format(PyExc_ValueError, "%s() arg is an empty sequence", consumer->kind == ConsumeMin ? "min" : "max");
+            return consumer->result;
+        case ConsumeTuple: {
+            auto res = PyList_AsTuple(consumer->result);
+            Py_DECREF(consumer->result);
+            return res;
+        }
+        default:
+            return consumer->result;
+    }
+}
+
+PyObject* PyJit_ConsumeGenerator(PyObject* callable, PyObject* iterable, int32_t kind) {
+    PyjionConsumer consumer = {(PyjionConsumerKind) kind, nullptr, SumInts, 0, 0.0, false};
+    if (!PyGen_CheckExact(iterable) || !PyJit_IsConsumer(callable, consumer.kind)) {
+        // Not a generator passed to the builtin (e.g. the name was rebound), make the call as written
+        auto res = PyObject_CallOneArg(callable, iterable);
+        Py_DECREF(callable);
+        Py_DECREF(iterable);
+        return res;
+    }
+
+    int32_t status = 0;
+    if (consumer.kind == ConsumeList || consumer.kind == ConsumeTuple)
+        consumer.result = PyList_New(0);
+    else if (consumer.kind == ConsumeSet)
+        consumer.result = PySet_New(nullptr);
+    if (consumer.kind >= ConsumeList && consumer.result == nullptr)
+        status = -1;
+
+    if (status == 0) {
+        // A generator expression that hasn't started yet can run as its consumer variant, see PyJit_EvalFrame
+        auto frame = ((PyGenObject*) iterable)->gi_frame;
+        bool fresh = frame != nullptr && frame->f_lasti == -1 &&
+                     PyUnicode_CompareWithASCIIString(frame->f_code->co_name, "<genexpr>") == 0;
+        if (fresh)
+            PyJit_RequestConsumer(frame, &consumer);
+        auto value = PyIter_Next(iterable);
+        if (fresh)
+            PyJit_WithdrawConsumer(&consumer);
+        if (consumer.taken) {
+            // The consumer variant passed every value to the consumer and returned instead of yielding
+            assert(value == nullptr);
+        } else {
+            while (value != nullptr && (status = PyJit_ConsumerAccept(&consumer, value)) == 0)
+                value = PyIter_Next(iterable);
+        }
+        if (status == 0 && PyErr_Occurred())
+            status = -1;
+    }
+
+    PyObject* res = nullptr;
+    if (status != -1)
+        res = PyJit_ConsumerFinish(&consumer);
+    else
+        Py_XDECREF(consumer.result);
+    Py_DECREF(callable);
+    Py_DECREF(iterable);
+    return res;
+}
+
 PyObject* PyJit_CellGet(PyFrameObject* frame, int32_t index) {
     PyObject** cells = frame->f_localsplus + frame->f_code->co_nlocals;
     PyObject* value = PyCell_GET(cells[index]);
@@ -2525,6 +3072,9 @@ inline void initialize_trace_info(PyTraceInfo* trace_info, PyFrameObject* frame)
 void PyJit_TraceLine(PyFrameObject* f, int instr_prev, PyTraceInfo* trace_info) {
     int result = 0;
     auto tstate = PyThreadState_GET();
+    // The same code runs with only a profiler attached, or after the tracer was removed
+    if (!trace_info->cframe.use_tracing || tstate->c_tracefunc == nullptr)
+        return;
     /* If the last instruction falls at the start of a line or if it
        represents a jump backwards, update the frame's line number and
        then call the trace function if we're tracing source lines.
@@ -31,7 +31,9 @@
 #include <vector>
 #include "types.h"
 #include "pyjit.h"
+#include "unboxing.h"
 #include "objects/unboxedrangeobject.h"
+#include "objects/unpackiterobject.h"
 
 #ifdef WINDOWS
 typedef SIZE_T size_t;
@@ -54,6 +56,7 @@ typedef SSIZE_T ssize_t;
 
 #define SIG_STOP_ITER  0x7fffffff
 #define SIG_ITER_ERROR 0xbeef
+#define SIG_UNBOXED_RETURN 0xface
 
 typedef struct {
     PyObject_HEAD
@@ -117,6 +120,10 @@ PyObject* PyJit_SubscrDict(PyObject* o, PyObject* key);
 PyObject* PyJit_SubscrDictHash(PyObject* o, PyObject* key, Py_hash_t hash);
 PyObject* PyJit_SubscrList(PyObject* o, PyObject* key);
 PyObject* PyJit_SubscrListIndex(PyObject* o, PyObject* key, Py_ssize_t index);
+// o[index] for an unboxed index that isn't known to be in range of a list, o is released
+PyObject* PyJit_SubscrListUnboxedIndex(PyObject* o, int64_t index);
+// Whether every value of range is an index of list, the guard that lets a range loop index list without bounds checks
+int32_t PyJit_RangeIndexesList(PyObject* range, PyObject* list);
 PyObject* PyJit_SubscrListSlice(PyObject* o, Py_ssize_t start, Py_ssize_t stop);
 PyObject* PyJit_SubscrListSliceStepped(PyObject* o, Py_ssize_t start, Py_ssize_t stop, Py_ssize_t step);
 PyObject* PyJit_SubscrListReversed(PyObject* o);
@@ -147,6 +154,9 @@ PyObject* PyJit_UnaryInvert(PyObject* value);
 
 PyObject* PyJit_NewList(int32_t size);
 PyObject* PyJit_ListAppend(PyObject* list, PyObject* value);
+PyObject* PyJit_NewComprehensionList(PyFrameObject* frame);
+PyObject* PyJit_NewComprehensionDict(PyFrameObject* frame);
+PyObject* PyJit_TrimList(PyObject* list);
 PyObject* PyJit_SetAdd(PyObject* set, PyObject* value);
 PyObject* PyJit_UpdateSet(PyObject* iterable, PyObject* set);
 PyObject* PyJit_MapAdd(PyObject* map, PyObject* key, PyObject* value);
@@ -178,6 +188,13 @@ PyObject* PyJit_InplaceAnd(PyObject* left, PyObject* right);
 PyObject* PyJit_InplaceXor(PyObject* left, PyObject* right);
 PyObject* PyJit_InplaceOr(PyObject* left, PyObject* right);
 
+PyObject* PyJit_ComplexBinaryOp(PyObject* left, PyObject* right, int32_t opcode);
+PyObject* PyJit_LoadComplexPart(PyObject* obj, PyObject* name, int32_t imag);
+
+int32_t PyJit_CheckMathMethod(PyJitMethodLocation* method_info, PyMethodDef* def);
+int32_t PyJit_MathError(double x, double result, const NativeMathFunction* function);
+PyObject* PyJit_UnboxedIntToString(int64_t value);
+
 int PyJit_PrintExpr(PyObject* value);
 
 void PyJit_HandleException(PyObject** exc, PyObject** val, PyObject** tb, PyObject** oldexc, PyObject** oldVal, PyObject** oldTb);
@@ -259,6 +276,41 @@ PyObject* PyJit_GetUnboxedIter(PyObject* iterable);
 
 PyObject* PyJit_IterNext(PyObject* iter);
 PyObject* PyJit_IterNextUnboxed(PyObject* iter);
+PyObject* PyJit_UnpackIterNew(PyObject* callable, PyObject* args, int32_t width, int32_t unboxedCounter);
+PyObject* PyJit_GetUnpackIter(PyObject* iterable, int32_t width);
+PyObject* PyJit_UnpackIterNext(PyObject* iter);
+
+enum PyjionConsumerKind {
+    ConsumeSum,
+    ConsumeAny,
+    ConsumeAll,
+    ConsumeMin,
+    ConsumeMax,
+    ConsumeList,
+    ConsumeTuple,
+    ConsumeSet,
+};
+
+enum PyjionSumPhase {
+    SumInts,
+    SumFloats,
+    SumObjects,
+};
+
+/* The builtin a generator expression is passed to, fed one value at a time by PyJit_ConsumerAccept. sum() keeps
+ * its total unboxed while the values are exact ints or floats, the same phases as builtin_sum. */
+struct PyjionConsumer {
+    PyjionConsumerKind kind;
+    PyObject* result;// Total once sum() leaves the unboxed phases, the answer of any()/all(), min()/max() so far or the container
+    PyjionSumPhase phase;
+    long intTotal;
+    double floatTotal;
+    bool taken;// Set by PyJit_EvalFrame when the generator expression runs as the consumer variant
+};
+
+bool PyJit_InitConsumers(PyjionInterpreterState* state);
+PyObject* PyJit_ConsumeGenerator(PyObject* callable, PyObject* iterable, int32_t kind);
+int32_t PyJit_ConsumerAccept(PyjionConsumer* consumer, PyObject* value);
 
 PyObject* PyJit_PyTuple_New(int32_t len);
 
@@ -305,7 +357,9 @@ PyObject* Call8(PyObject* target, PyObject* arg0, PyObject* arg1, PyObject* arg2
 PyObject* Call9(PyObject* target, PyObject* arg0, PyObject* arg1, PyObject* arg2, PyObject* arg3, PyObject* arg4, PyObject* arg5, PyObject* arg6, PyObject* arg7, PyObject* arg8, PyTraceInfo* trace_info);
 PyObject* Call10(PyObject* target, PyObject* arg0, PyObject* arg1, PyObject* arg2, PyObject* arg3, PyObject* arg4, PyObject* arg5, PyObject* arg6, PyObject* arg7, PyObject* arg8, PyObject* arg9, PyTraceInfo* trace_info);
 
-extern PyObject* g_emptyTuple;
+bool PyJit_InitBoxing(PyjionInterpreterState* state);
+void PyJit_FreeBoxing(PyjionInterpreterState* state);
+PyObject* PyJit_FloatFromDouble(double value);
 
 void PyJit_DecRef(PyObject* value);
 
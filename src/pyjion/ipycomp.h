@@ -31,6 +31,7 @@
 #include "absvalue.h"
 #include "codemodel.h"
 #include "instructions.h"
+#include "unboxing.h"
 #include "frame.h"
 
 #ifdef WINDOWS
@@ -247,7 +248,8 @@ public:
     virtual void emit_store_subscr(AbstractValueWithSources, AbstractValueWithSources, AbstractValueWithSources) = 0;
 
     virtual void emit_delete_subscr() = 0;
-    virtual void emit_pending_calls() = 0;
+    // Runs the pending calls every EMIT_PENDING_CALL_COUNTER back edges, clearing the int locals in invalidated when they run
+    virtual void emit_pending_calls(const vector<Local>& invalidated) = 0;
     virtual void emit_init_instr_counter() = 0;
 
     /*****************************************************
@@ -271,6 +273,12 @@ public:
     virtual void emit_list_store(py_oparg argCnt) = 0;
     // Appends a single value to a list
     virtual void emit_list_append() = 0;
+    // Creates the list of a list comprehension, with room for the items left in its list, tuple or range iterator
+    virtual void emit_new_comprehension_list() = 0;
+    // Creates the dict of a dict comprehension, presized for the items left in its list, tuple or range iterator
+    virtual void emit_new_comprehension_dict() = 0;
+    // Gives back the unused room of a comprehension's list, like list_resize() does when shrinking
+    virtual void emit_trim_list() = 0;
     // Extends a list with a single iterable
     virtual void emit_list_extend() = 0;
     // Updates a dictionary with a property
@@ -376,6 +384,26 @@ public:
     virtual void emit_getiter_unboxed() = 0;
     virtual void emit_for_next() = 0;
     virtual void emit_for_next_unboxed() = 0;
+    // Replaces a known list or tuple with itself and resets the loop index, falls back to an iterator on a failed guard
+    virtual void emit_getiter_sequence(Local index, Local size, AbstractValueWithSources iterable) = 0;
+    // Loads the next item of a list or tuple by index, or SIG_STOP_ITER once the index reaches the size
+    virtual void emit_for_next_sequence(Local index, Local size, AbstractValueWithSources iterable) = 0;
+    // Calls enumerate() or zip() with a tuple of arguments, returning an iterator that yields width items per step without a tuple.
+    // With unboxedCounter the enumerate counter is never boxed, the loop unpacks it with emit_unpack_enumerate
+    virtual void emit_unpack_iter_new(py_oparg width, bool unboxedCounter) = 0;
+    // Gets an iterator for a dict or dict view that yields width items per step without a tuple, or a regular iterator
+    virtual void emit_getiter_unpack(py_oparg width) = 0;
+    // Gets the next step of an iterator from emit_unpack_iter_new or emit_getiter_unpack, or the next item of any other iterator
+    virtual void emit_for_next_unpack() = 0;
+    // Unpacks the current step of an iterator from emit_unpack_iter_new or emit_getiter_unpack, or any other iterable, onto the stack
+    virtual void emit_unpack_iter(py_oparg size, AbstractValueWithSources iterable) = 0;
+    // Unpacks the current step of an enumerate() iterator from emit_unpack_iter_new with an unboxed counter, pushing the item
+    // and then the counter as an unboxed int. Branches to generic with the iterator still on the stack if it's another iterator
+    virtual void emit_unpack_enumerate(Label generic) = 0;
+    // Calls sum(), any(), all(), min(), max(), list(), tuple() or set() with a generator expression, running the generator as its consumer variant
+    virtual void emit_consume_generator(int32_t kind) = 0;
+    // Passes the value being yielded by a consumer variant to its consumer, pushing 0 to resume, 1 once the consumer has its result or -1 on error
+    virtual void emit_consume_value() = 0;
 
     /*****************************************************
      * Operators */
@@ -404,6 +432,11 @@ public:
     virtual void emit_binary_subscr() = 0;
     virtual void emit_binary_subscr(AbstractValueWithSources left, AbstractValueWithSources right) = 0;
     virtual LocalKind emit_unboxed_binary_subscr(AbstractValueWithSources left, AbstractValueWithSources right) = 0;
+    // Indexes the list on the stack by the unboxed int on top of it, pushing the item or NULL on error. When inBounds is
+    // valid and holds 1 the index is known to be in range of an exact list and isn't checked.
+    virtual void emit_list_index(Local inBounds) = 0;
+    // Stores in guard whether the range on the stack is in range of each of the lists in locals, leaving the range on the stack
+    virtual void emit_range_indexes_lists(const vector<py_oparg>& lists, Local guard) = 0;
     virtual bool emit_binary_subscr_slice(AbstractValueWithSources container, AbstractValueWithSources start, AbstractValueWithSources stop) = 0;
     virtual bool emit_binary_subscr_slice(AbstractValueWithSources container, AbstractValueWithSources start, AbstractValueWithSources stop, AbstractValueWithSources step) = 0;
 
@@ -488,8 +521,49 @@ public:
     virtual void emit_nan() = 0;
     virtual void emit_infinity_long() = 0;
     virtual void emit_nan_long() = 0;
+    // Converts an unboxed int or bool to a float
+    virtual void emit_int_to_float() = 0;
+    // Truncates an unboxed float to an int, the value must be in range
+    virtual void emit_float_to_int() = 0;
+    // Converts an unboxed float of any size to a new int object, pushing NULL on error for infinity and NaN
+    virtual void emit_float_to_int_object() = 0;
     virtual void emit_guard_exception(const char* expected) = 0;
 
+    // Checks the method loaded from the math module is the builtin with def, pushing 1 and releasing it if so, otherwise 0
+    virtual void emit_check_math_method(PyMethodDef* def) = 0;
+    // Calls the libm function on the unboxed float on the stack, pushing the unboxed float result
+    virtual void emit_math_function(const NativeMathFunction* function) = 0;
+    // Pushes 1 if the result of the function on the stack is an ordinary value, 0 if it is infinite, NaN or out of range
+    virtual void emit_math_result_check(const NativeMathFunction* function) = 0;
+    // Sets the error for the argument and result on the stack as the math module would, pushing 1 if one was set
+    virtual void emit_math_error(const NativeMathFunction* function) = 0;
+
+    // Pushes the unboxed length of a list, tuple, str, bytes, dict or set in container, branching to fallback if it is another type
+    virtual void emit_len(Local container, AbstractValueWithSources value, Label fallback) = 0;
+    // Pushes the absolute value of the unboxed int or float on the stack
+    virtual void emit_unboxed_abs(AbstractValueKind kind) = 0;
+    // Pushes the unboxed abs() of the complex in complex, branching to fallback if it is another type or the result isn't finite
+    virtual void emit_complex_abs(Local complex, AbstractValueWithSources value, Label fallback) = 0;
+    // Pushes the smaller (or greater) of the two unboxed ints or floats on the stack
+    virtual void emit_unboxed_min_max(AbstractValueKind kind, bool isMax) = 0;
+    // Checks whether the object on the stack is an instance of a builtin type, pushing 1, 0 or -1 on error. The object isn't released.
+    virtual void emit_isinstance(PyTypeObject* type) = 0;
+    // Pushes 1 if the unboxed float on the stack can be truncated to an unboxed int, 0 if it is out of range or NaN
+    virtual void emit_float_in_int_range() = 0;
+    // Converts an unboxed int, bool or float (which must be in range) to an unboxed int, as int() does
+    virtual void emit_unboxed_to_int(AbstractValueKind kind) = 0;
+    // Converts an unboxed int, bool or float to an unboxed bool, as bool() does
+    virtual void emit_unboxed_to_bool(AbstractValueKind kind) = 0;
+    // Formats the unboxed int on the stack as a new string, pushing NULL on error
+    virtual void emit_unboxed_int_to_str() = 0;
+    // Calls the function on the stack with nargs arguments through PyJit_CallDirect, storing its unboxed result in result and
+    // pushing 0, or -1 on error. The arguments are objects or the addresses of unboxed values, as given by argKinds.
+    virtual void emit_call_direct(py_oparg nargs, int32_t argKinds, AbstractValueKind kind, Local result) = 0;
+    // Stores the unboxed int or float on the stack in the PyjionDirectCall of a direct variant, pushing SIG_UNBOXED_RETURN to return
+    virtual void emit_unboxed_return(AbstractValueKind kind) = 0;
+    // Pushes the unboxed int or float argument arg of a direct variant from its PyjionDirectCall
+    virtual void emit_load_direct_arg(size_t arg, AbstractValueKind kind) = 0;
+
     virtual void emit_store_in_frame_value_stack(uint32_t idx) = 0;
     virtual void emit_load_from_frame_value_stack(uint32_t idx) = 0;
     virtual void emit_dec_frame_stackdepth(uint32_t by) = 0;
@@ -44,10 +44,7 @@
 #include "cee.h"
 #include "ipycomp.h"
 #include "exceptions.h"
-
-#ifndef WINDOWS
-#include <sys/mman.h>
-#endif
+#include "codearena.h"
 
 #ifdef DEBUG_VERBOSE
 #define WARN(msg, ...) printf(#msg, ##__VA_ARGS__);
@@ -80,7 +77,6 @@ class CorJitInfo : public ICorJitInfo, public JittedCode {
     volatile const GSCookie s_gsCookie = 0x1234;
 
 #ifdef WINDOWS
-    HANDLE m_winHeap;
     SYSTEM_INFO systemInfo;
 #endif
 
@@ -94,21 +90,15 @@ public:
         m_nativeSize = 0;
         m_compileDebug = compileDebug;
 #ifdef WINDOWS
-        m_winHeap = HeapCreate(HEAP_CREATE_ENABLE_EXECUTE, 0, 0);
         GetSystemInfo(&systemInfo);
 #endif
     }
 
     ~CorJitInfo() override {
-        if (m_codeAddr != nullptr) {
-            freeMem(m_codeAddr);
-        }
+        // The code is allocated from g_codeArena, which doesn't release memory
         if (m_dataAddr != nullptr) {
             free(m_dataAddr);
         }
-#ifdef WINDOWS
-        HeapDestroy(m_winHeap);
-#endif
         delete m_module;
     }
 
@@ -200,39 +190,16 @@ public:
         return m_module->GetSymbolTable();
     }
 
-    void freeMem(PVOID code) {
-        PyMem_Free(code);
-    }
-
     void allocMem(
             AllocMemArgs* pArgs) override {
         // NB: Not honouring flag alignment requested in <flag>, but it is "optional"
-#ifdef WINDOWS
-        pArgs->hotCodeBlock = m_codeAddr = HeapAlloc(m_winHeap, 0, pArgs->hotCodeSize);
-#else
-#if defined(__APPLE__) && defined(MAP_JIT)
-        const int mode = MAP_PRIVATE | MAP_ANONYMOUS | MAP_JIT;
-#elif defined(MAP_ANONYMOUS)
-        const int mode = MAP_PRIVATE | MAP_ANONYMOUS;
-#elif defined(MAP_ANON)
-        const int mode = MAP_PRIVATE | MAP_ANON;
-#else
-#error "not supported"
-#endif
-        pArgs->hotCodeBlock = m_codeAddr = mmap(
-                nullptr,
-                pArgs->hotCodeSize,
-                PROT_READ | PROT_WRITE | PROT_EXEC,
-                mode,
-                -1,
-                0);
-        assert(pArgs->hotCodeBlock != MAP_FAILED);
-#endif
-
-        if (pArgs->coldCodeSize > 0)// PyMem_Malloc passes with 0 but it confuses the JIT
-            pArgs->coldCodeBlock = PyMem_Malloc(pArgs->coldCodeSize);
+        // Hot code, cold code and read-only data are packed next to each other in the arena
+        pArgs->hotCodeBlock = m_codeAddr = g_codeArena.allocate(pArgs->hotCodeSize);
+        assert(pArgs->hotCodeBlock != nullptr);
+        if (pArgs->coldCodeSize > 0)// The arena would return a block for 0 but it confuses the JIT
+            pArgs->coldCodeBlock = g_codeArena.allocate(pArgs->coldCodeSize);
         if (pArgs->roDataSize > 0)// Same as above
-            pArgs->roDataBlock = PyMem_Malloc(pArgs->roDataSize);
+            pArgs->roDataBlock = g_codeArena.allocate(pArgs->roDataSize);
 
         pArgs->hotCodeBlockRW = pArgs->hotCodeBlock;
         pArgs->coldCodeBlockRW = pArgs->coldCodeBlock;
@@ -1655,7 +1622,7 @@ public:
 #ifdef INDIRECT_HELPERS
     void* getHelperFtn(CorInfoHelpFunc ftnNum, void** ppIndirection) override {
         *ppIndirection = nullptr;
-        static void* helper = nullptr;
+        void* helper = nullptr;
         switch (ftnNum) {
             case CORINFO_HELP_USER_BREAKPOINT:
                 helper = (void*) &breakpointFtn;
@@ -1786,7 +1753,7 @@ public:
     }
 
     void* allocGCInfo(size_t size) override {
-        return PyMem_Malloc(size);
+        return PyMem_RawMalloc(size);
     }
 
     void setEHcount(unsigned int cEH) override {
@@ -0,0 +1,280 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) Microsoft Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include "unpackiterobject.h"
+#include "unboxedrangeobject.h"
+#include <cstddef>
+
+static bool
+unpacksource_init(pyjion_unpacksource* source, PyObject* seq, bool allowItems) {
+    source->start = 0;
+    source->step = 1;
+    source->pos = 0;
+    source->used = 0;
+    if (PyList_CheckExact(seq)) {
+        source->kind = UnpackList;
+        source->len = 0;
+    } else if (PyTuple_CheckExact(seq)) {
+        source->kind = UnpackTuple;
+        source->len = PyTuple_GET_SIZE(seq);
+    } else if (PyRange_Check(seq)) {
+        // Only ranges where every item fits in a Py_ssize_t can be stepped without boxing
+        auto* r = (py_rangeobject*) seq;
+        source->kind = UnpackRange;
+        source->start = PyLong_AsSsize_t(r->start);
+        source->step = PyLong_AsSsize_t(r->step);
+        source->len = PyLong_AsSsize_t(r->length);
+        Py_ssize_t stop = PyLong_AsSsize_t(r->stop);
+        if ((source->start == -1 || source->step == -1 || source->len == -1 || stop == -1) && PyErr_Occurred()) {
+            PyErr_Clear();
+            return false;
+        }
+    } else if (PyDict_CheckExact(seq) || PyDictKeys_Check(seq) || PyDictValues_Check(seq) || (allowItems && PyDictItems_Check(seq))) {
+        if (PyDictKeys_Check(seq) || PyDictValues_Check(seq) || PyDictItems_Check(seq)) {
+            source->kind = PyDictKeys_Check(seq) ? UnpackDictKeys : PyDictValues_Check(seq) ? UnpackDictValues : UnpackDictItems;
+            seq = (PyObject*) ((_PyDictViewObject*) seq)->dv_dict;
+            if (seq == nullptr || !PyDict_CheckExact(seq))
+                return false;
+        } else {
+            source->kind = UnpackDictKeys;
+        }
+        source->used = ((PyDictObject*) seq)->ma_used;
+        source->len = source->used;
+    } else {
+        return false;
+    }
+    source->seq = seq;
+    return true;
+}
+
+static pyjion_unpackiterobject*
+unpackiter_new(pyjion_unpacksource* sources, Py_ssize_t nsources, Py_ssize_t width, bool enumerate, Py_ssize_t counter, bool tuples,
+               bool unboxedCounter) {
+    auto it = PyObject_NewVar(pyjion_unpackiterobject, &PyjionUnpackIter_Type, width);
+    if (it == nullptr) {
+        PyMem_Free(sources);
+        return nullptr;
+    }
+    it->index = 0;
+    it->counter = counter;
+    it->enumerate = enumerate ? 1 : 0;
+    it->tuples = tuples ? 1 : 0;
+    it->unboxedCounter = enumerate && unboxedCounter ? 1 : 0;
+    it->nsources = nsources;
+    it->sources = sources;
+    for (Py_ssize_t i = 0; i < width; i++)
+        it->items[i] = nullptr;
+    for (Py_ssize_t i = 0; i < nsources; i++)
+        Py_INCREF(sources[i].seq);
+    return it;
+}
+
+PyObject* PyjionUnpackIter_FromCall(PyObject* callable, PyObject* args, Py_ssize_t width, bool unboxedCounter) {
+    bool enumerate;
+    if (callable == (PyObject*) &PyEnum_Type) {
+        enumerate = true;
+    } else if (callable == (PyObject*) &PyZip_Type) {
+        enumerate = false;
+    } else {
+        return nullptr;
+    }
+
+    Py_ssize_t nargs = PyTuple_GET_SIZE(args), nsources = nargs, counter = 0;
+    if (enumerate) {
+        if (nargs == 2) {
+            auto start = PyTuple_GET_ITEM(args, 1);
+            if (!PyLong_CheckExact(start))
+                return nullptr;
+            counter = PyLong_AsSsize_t(start);
+            if (counter == -1 && PyErr_Occurred()) {
+                PyErr_Clear();
+                return nullptr;
+            }
+            // Leave headroom so counter + index can't overflow
+            if (counter > PY_SSIZE_T_MAX / 2 || counter < PY_SSIZE_T_MIN / 2)
+                return nullptr;
+        } else if (nargs != 1) {
+            return nullptr;
+        }
+        nsources = 1;
+    }
+    if (nsources == 0 || nsources + (enumerate ? 1 : 0) != width)
+        return nullptr;
+
+    auto sources = PyMem_New(pyjion_unpacksource, nsources);
+    if (sources == nullptr)
+        return PyErr_NoMemory();
+    for (Py_ssize_t i = 0; i < nsources; i++) {
+        // zip() and enumerate() yield the (key, value) tuples of items() as single items
+        if (!unpacksource_init(&sources[i], PyTuple_GET_ITEM(args, i), false)) {
+            PyMem_Free(sources);
+            return nullptr;
+        }
+    }
+    return (PyObject*) unpackiter_new(sources, nsources, width, enumerate, counter, true, unboxedCounter);
+}
+
+PyObject* PyjionUnpackIter_FromIterable(PyObject* iterable, Py_ssize_t width) {
+    if (!PyDict_CheckExact(iterable) && !PyDictKeys_Check(iterable) && !PyDictValues_Check(iterable) && !PyDictItems_Check(iterable))
+        return nullptr;
+    if (width != (PyDictItems_Check(iterable) ? 2 : 1))
+        return nullptr;
+
+    auto sources = PyMem_New(pyjion_unpacksource, 1);
+    if (sources == nullptr)
+        return PyErr_NoMemory();
+    if (!unpacksource_init(sources, iterable, true)) {
+        PyMem_Free(sources);
+        return nullptr;
+    }
+    return (PyObject*) unpackiter_new(sources, 1, width, false, 0, false, false);
+}
+
+static void
+unpackiter_clear_items(pyjion_unpackiterobject* it) {
+    for (Py_ssize_t i = 0; i < Py_SIZE(it); i++)
+        Py_CLEAR(it->items[i]);
+}
+
+int PyjionUnpackIter_Advance(pyjion_unpackiterobject* it) {
+    unpackiter_clear_items(it);
+    Py_ssize_t index = it->index;
+    Py_ssize_t slot = it->enumerate;
+    for (Py_ssize_t i = 0; i < it->nsources; i++) {
+        auto source = &it->sources[i];
+        switch (source->kind) {
+            case UnpackList:
+                if (index >= PyList_GET_SIZE(source->seq))
+                    goto stop;
+                it->items[slot++] = Py_NewRef(PyList_GET_ITEM(source->seq, index));
+                break;
+            case UnpackTuple:
+                if (index >= source->len)
+                    goto stop;
+                it->items[slot++] = Py_NewRef(PyTuple_GET_ITEM(source->seq, index));
+                break;
+            case UnpackRange:
+                if (index >= source->len)
+                    goto stop;
+                it->items[slot] = PyLong_FromSsize_t(source->start + index * source->step);
+                if (it->items[slot++] == nullptr)
+                    goto error;
+                break;
+            default: {
+                // Same checks as the dict iterators, see dictiter_iternextkey()
+                PyObject *key, *value;
+                if (source->used != ((PyDictObject*) source->seq)->ma_used) {
+                    PyErr_SetString(PyExc_RuntimeError, "dictionary changed size during iteration");
+                    source->used = -1;
+                    goto error;
+                }
+                if (!PyDict_Next(source->seq, &source->pos, &key, &value))
+                    goto stop;
+                if (source->len == 0) {
+                    PyErr_SetString(PyExc_RuntimeError, "dictionary keys changed during iteration");
+                    goto error;
+                }
+                source->len--;
+                if (source->kind != UnpackDictValues)
+                    it->items[slot++] = Py_NewRef(key);
+                if (source->kind != UnpackDictKeys)
+                    it->items[slot++] = Py_NewRef(value);
+                break;
+            }
+        }
+    }
+    if (it->enumerate && !it->unboxedCounter) {
+        it->items[0] = PyLong_FromSsize_t(it->counter + index);
+        if (it->items[0] == nullptr)
+            goto error;
+    }
+    it->index++;
+    return 1;
+
+stop:
+    unpackiter_clear_items(it);
+    return 0;
+error:
+    unpackiter_clear_items(it);
+    return -1;
+}
+
+static PyObject*
+unpackiter_next(pyjion_unpackiterobject* it) {
+    if (PyjionUnpackIter_Advance(it) != 1)
+        return nullptr;
+    if (PyjionUnpackIter_IsDirect(it)) {
+        auto item = it->items[0];
+        it->items[0] = nullptr;
+        return item;
+    }
+    auto result = PyTuple_New(Py_SIZE(it));
+    if (result == nullptr)
+        return nullptr;
+    for (Py_ssize_t i = 0; i < Py_SIZE(it); i++) {
+        PyTuple_SET_ITEM(result, i, it->items[i]);
+        it->items[i] = nullptr;
+    }
+    return result;
+}
+
+static void
+unpackiter_dealloc(pyjion_unpackiterobject* it) {
+    unpackiter_clear_items(it);
+    for (Py_ssize_t i = 0; i < it->nsources; i++)
+        Py_DECREF(it->sources[i].seq);
+    PyMem_Free(it->sources);
+    PyObject_Del(it);
+}
+
+PyTypeObject PyjionUnpackIter_Type = {
+        PyVarObject_HEAD_INIT(&PyType_Type, 0) "pyjion_unpack_iterator", /* tp_name */
+        offsetof(pyjion_unpackiterobject, items),                        /* tp_basicsize */
+        sizeof(PyObject*),                                               /* tp_itemsize */
+        /* methods */
+        (destructor) unpackiter_dealloc, /* tp_dealloc */
+        0,                               /* tp_vectorcall_offset */
+        0,                               /* tp_getattr */
+        0,                               /* tp_setattr */
+        0,                               /* tp_as_async */
+        0,                               /* tp_repr */
+        0,                               /* tp_as_number */
+        0,                               /* tp_as_sequence */
+        0,                               /* tp_as_mapping */
+        0,                               /* tp_hash */
+        0,                               /* tp_call */
+        0,                               /* tp_str */
+        PyObject_GenericGetAttr,         /* tp_getattro */
+        0,                               /* tp_setattro */
+        0,                               /* tp_as_buffer */
+        Py_TPFLAGS_DEFAULT,              /* tp_flags */
+        0,                               /* tp_doc */
+        0,                               /* tp_traverse */
+        0,                               /* tp_clear */
+        0,                               /* tp_richcompare */
+        0,                               /* tp_weaklistoffset */
+        PyObject_SelfIter,               /* tp_iter */
+        (iternextfunc) unpackiter_next,  /* tp_iternext */
+};
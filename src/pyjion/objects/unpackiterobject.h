@@ -0,0 +1,81 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) Microsoft Corporation
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+* OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+* OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+* ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+
+#include <Python.h>
+
+#ifndef PYJION_UNPACKITEROBJECT_H
+#define PYJION_UNPACKITEROBJECT_H
+
+enum PyjionUnpackSourceKind {
+    UnpackList,
+    UnpackTuple,
+    UnpackRange,
+    UnpackDictKeys,
+    UnpackDictValues,
+    UnpackDictItems,
+};
+
+typedef struct {
+    PyObject* seq;   // list, tuple, range or dict
+    int32_t kind;    // PyjionUnpackSourceKind
+    Py_ssize_t start;// range start
+    Py_ssize_t step; // range step
+    Py_ssize_t len;  // tuple or range length or entries left in a dict, lists are measured on every step
+    Py_ssize_t pos;  // position in the entries of a dict
+    Py_ssize_t used; // ma_used of a dict when the loop started, to detect a resize
+} pyjion_unpacksource;
+
+/* Iterator for a for loop over enumerate(), zip() or a dict that unpacks each step straight into its targets.
+   The items of the current step are kept in `items` instead of a new tuple, and the enumerate counter
+   is kept unboxed until it is handed out, or never boxed when the jitted loop reads it directly. */
+typedef struct {
+    PyObject_VAR_HEAD
+            Py_ssize_t index;
+    Py_ssize_t counter;// enumerate start value
+    int32_t enumerate;
+    int32_t tuples;// steps are tuples, even of a single item
+    int32_t unboxedCounter;// items[0] is left empty, the jitted loop computes counter + index - 1 itself
+    Py_ssize_t nsources;
+    pyjion_unpacksource* sources;
+    PyObject* items[1];// ob_size items of the current step, owned until they are unpacked
+} pyjion_unpackiterobject;
+
+PyAPI_DATA(PyTypeObject) PyjionUnpackIter_Type;
+#define PyjionUnpackIter_Check(op) Py_IS_TYPE(op, &PyjionUnpackIter_Type)
+
+/* Creates an iterator for callable(*args) if callable is enumerate or zip over lists, tuples, ranges or dicts and
+   each step has width items. Returns nullptr without an error set when the call can't be replaced. */
+PyObject* PyjionUnpackIter_FromCall(PyObject* callable, PyObject* args, Py_ssize_t width, bool unboxedCounter);
+
+/* Creates an iterator for a dict, or its keys(), values() or items() view, if each step has width items.
+   Returns nullptr without an error set for any other iterable. */
+PyObject* PyjionUnpackIter_FromIterable(PyObject* iterable, Py_ssize_t width);
+
+/* Moves to the next step. Returns 1 when items were loaded, 0 when exhausted and -1 on error. */
+int PyjionUnpackIter_Advance(pyjion_unpackiterobject* it);
+
+/* True if each step is a single item, handed out directly instead of being unpacked */
+#define PyjionUnpackIter_IsDirect(it) (!(it)->tuples && Py_SIZE(it) == 1)
+#endif//PYJION_UNPACKITEROBJECT_H
@@ -50,7 +50,15 @@ PythonCompiler::PythonCompiler(PyCodeObject* code) : m_il(m_module = new UserMod
                                                           }) {
     this->m_code = code;
     m_lasti = m_il.define_local(Parameter(CORINFO_TYPE_NATIVEINT));
-    m_compileDebug = g_pyjionSettings.debug;
+    m_compileDebug = PyJit_Settings().debug;
+}
+
+PythonCompiler::~PythonCompiler() {
+    delete m_pendingJitInfo;
+}
+
+void PythonCompiler::defer_native_compile() {
+    m_deferNativeCompile = true;
 }
 
 void PythonCompiler::load_frame() {
@@ -995,6 +1003,16 @@ void PythonCompiler::emit_load_attr(PyObject* name, AbstractValueWithSources obj
         m_il.emit_call(METHOD_LOADATTR_TOKEN);
         return;
     }
+    if (obj.Value->kind() == AVK_Complex) {
+        bool real = PyUnicode_CompareWithASCIIString(name, "real") == 0;
+        if (real || PyUnicode_CompareWithASCIIString(name, "imag") == 0) {
+            // Read cval directly, falls back to getattr if the guessed type was wrong
+            m_il.ld_i(name);
+            m_il.ld_i4(real ? 0 : 1);
+            m_il.emit_call(METHOD_LOAD_COMPLEX_PART);
+            return;
+        }
+    }
     bool guard = obj.Value->needsGuard();
     Local objLocal = emit_define_local(LK_Pointer);
     emit_store_local(objLocal);
@@ -1126,7 +1144,7 @@ void PythonCompiler::emit_delete_fast(py_oparg index) {
 
 void PythonCompiler::emit_new_tuple(py_oparg size) {
     if (size == 0) {
-        emit_ptr(g_emptyTuple);
+        emit_ptr(PyJit_InterpreterState()->emptyTuple);
         m_il.dup();
         // incref 0-tuple so it never gets freed
         emit_incref();
@@ -1336,6 +1354,70 @@ void PythonCompiler::emit_binary_subscr(AbstractValueWithSources container, Abst
     }
 }
 
+void PythonCompiler::emit_list_index(Local inBounds) {
+    // The list is checked to be exact so the item can be read from ob_item, anything else takes the slow path
+    Local index = emit_define_local(LK_Int), list = emit_define_local(LK_Pointer);
+    Label read = emit_define_label(), slow = emit_define_label(), done = emit_define_label();
+    emit_store_local(index);
+    emit_store_local(list);
+    if (inBounds.is_valid()) {
+        // The loop guard has already checked the type and that every index of the loop is in range
+        emit_load_local(inBounds);
+        emit_branch(BranchTrue, read);
+    }
+    emit_load_local(list);
+    LD_FIELDI(PyObject, ob_type);
+    emit_ptr(&PyList_Type);
+    emit_branch(BranchNotEqual, slow);
+    // Negative indexes are large as unsigned, so one comparison covers both ends
+    emit_load_local(index);
+    emit_load_local(list);
+    emit_list_length();
+    emit_branch(BranchGreaterThanEqualUnsigned, slow);
+
+    emit_mark_label(read);
+    emit_load_local(list);
+    LD_FIELDI(PyListObject, ob_item);
+    emit_load_local(index);
+    m_il.conv_i();
+    emit_sizet(sizeof(PyObject*));
+    m_il.mul();
+    m_il.add();
+    m_il.ld_ind_i();
+    m_il.dup();
+    emit_incref();
+    emit_load_local(list);
+    decref();
+    emit_branch(BranchAlways, done);
+
+    emit_mark_label(slow);
+    emit_load_local(list);
+    emit_load_local(index);
+    m_il.emit_call(METHOD_SUBSCR_LIST_UNBOXED);
+
+    emit_mark_label(done);
+    emit_free_local(index);
+    emit_free_local(list);
+}
+
+void PythonCompiler::emit_range_indexes_lists(const vector<py_oparg>& lists, Local guard) {
+    // The range stays on the stack for GET_ITER
+    Label failed = emit_define_label(), done = emit_define_label();
+    for (auto& list : lists) {
+        m_il.dup();
+        emit_load_fast(list);
+        m_il.emit_call(METHOD_RANGE_INDEXES_LIST);
+        emit_branch(BranchFalse, failed);
+    }
+    emit_int(1);
+    emit_store_local(guard);
+    emit_branch(BranchAlways, done);
+    emit_mark_label(failed);
+    emit_int(0);
+    emit_store_local(guard);
+    emit_mark_label(done);
+}
+
 bool PythonCompiler::emit_binary_subscr_slice(AbstractValueWithSources container, AbstractValueWithSources start, AbstractValueWithSources stop) {
     bool startIndex = false, stopIndex = false;
     Py_ssize_t start_i, stop_i;
@@ -1826,7 +1908,61 @@ void PythonCompiler::emit_map_add() {
 }
 
 void PythonCompiler::emit_list_append() {
+    // Stores into the spare room of the list directly, PyList_Append is only called when the list has to grow
+    Label resize = emit_define_label(), done = emit_define_label();
+    Local value = emit_define_local(LK_NativeInt), list = emit_define_local(LK_NativeInt), size = emit_define_local(LK_NativeInt);
+    emit_store_local(value);
+    emit_store_local(list);
+
+    emit_load_local(list);
+    emit_list_length();
+    emit_store_local(size);
+    emit_load_local(size);
+    emit_load_local(list);
+    LD_FIELDI(PyListObject, allocated);
+    emit_branch(BranchGreaterThanEqual, resize);
+
+    // ob_item[size] = value, ob_size = size + 1
+    emit_load_local(list);
+    LD_FIELDI(PyListObject, ob_item);
+    emit_load_local(size);
+    emit_sizet(sizeof(PyObject*));
+    m_il.mul();
+    m_il.add();
+    emit_load_local(value);
+    m_il.st_ind_i();
+    emit_load_local(list);
+    LD_FIELDA(PyVarObject, ob_size);
+    emit_load_local(size);
+    emit_sizet(1);
+    m_il.add();
+    m_il.st_ind_i();
+    emit_load_local(list);
+    emit_branch(BranchAlways, done);
+
+    emit_mark_label(resize);
+    emit_load_local(list);
+    emit_load_local(value);
     m_il.emit_call(METHOD_LIST_APPEND_TOKEN);
+
+    emit_mark_label(done);
+    emit_free_local(value);
+    emit_free_local(list);
+    emit_free_local(size);
+}
+
+void PythonCompiler::emit_new_comprehension_list() {
+    load_frame();
+    m_il.emit_call(METHOD_NEW_COMPREHENSION_LIST);
+}
+
+void PythonCompiler::emit_new_comprehension_dict() {
+    load_frame();
+    m_il.emit_call(METHOD_NEW_COMPREHENSION_DICT);
+}
+
+void PythonCompiler::emit_trim_list() {
+    m_il.emit_call(METHOD_TRIM_LIST);
 }
 
 void PythonCompiler::emit_null() {
@@ -1887,6 +2023,176 @@ void PythonCompiler::emit_for_next_unboxed() {
     m_il.emit_call(METHOD_FORITER_UNBOXED);
 }
 
+void PythonCompiler::emit_unpack_iter_new(py_oparg width, bool unboxedCounter) {
+    m_il.ld_i4(width);
+    m_il.ld_i4(unboxedCounter ? 1 : 0);
+    m_il.emit_call(METHOD_UNPACK_ITER_NEW);
+}
+
+void PythonCompiler::emit_getiter_unpack(py_oparg width) {
+    m_il.ld_i4(width);
+    m_il.emit_call(METHOD_GET_UNPACK_ITER);
+}
+
+void PythonCompiler::emit_for_next_unpack() {
+    m_il.emit_call(METHOD_UNPACK_ITER_NEXT);
+}
+
+void PythonCompiler::emit_unpack_iter(py_oparg size, AbstractValueWithSources iterable) {
+    Label generic = emit_define_label(), done = emit_define_label();
+    m_il.dup();
+    LD_FIELDI(PyObject, ob_type);
+    emit_ptr(&PyjionUnpackIter_Type);
+    emit_branch(BranchNotEqual, generic);
+
+    // Take the items of the current step out of the iterator, which stood in for the tuple
+    Local t_iter = emit_define_local(LK_NativeInt);
+    emit_store_local(t_iter);
+    py_oparg idx = size;
+    while (idx--) {
+        size_t offset = offsetof(pyjion_unpackiterobject, items) + idx * sizeof(PyObject*);
+        emit_load_local(t_iter);
+        emit_sizet(offset);
+        m_il.add();
+        m_il.ld_ind_i();
+
+        emit_load_local(t_iter);
+        emit_sizet(offset);
+        m_il.add();
+        m_il.load_null();
+        m_il.st_ind_i();
+    }
+    emit_load_and_free_local(t_iter);
+    decref();
+    emit_int(0);
+    emit_branch(BranchAlways, done);
+
+    emit_mark_label(generic);
+    emit_unpack_generic(size, iterable);
+    emit_mark_label(done);
+}
+
+void PythonCompiler::emit_unpack_enumerate(Label generic) {
+    m_il.dup();
+    LD_FIELDI(PyObject, ob_type);
+    emit_ptr(&PyjionUnpackIter_Type);
+    emit_branch(BranchNotEqual, generic);
+
+    // The item is taken out of the iterator, the counter of the step was never boxed
+    Local t_iter = emit_define_local(LK_NativeInt);
+    emit_store_local(t_iter);
+    emit_load_local(t_iter);
+    LD_FIELDI(pyjion_unpackiterobject, items[1]);
+    emit_load_local(t_iter);
+    LD_FIELDA(pyjion_unpackiterobject, items[1]);
+    m_il.load_null();
+    m_il.st_ind_i();
+
+    emit_load_local(t_iter);
+    LD_FIELDI(pyjion_unpackiterobject, counter);
+    emit_load_local(t_iter);
+    LD_FIELDI(pyjion_unpackiterobject, index);
+    m_il.add();
+    m_il.load_one();
+    m_il.sub();
+    m_il.conv_i8();
+    emit_load_and_free_local(t_iter);
+    decref();
+}
+
+void PythonCompiler::emit_consume_generator(int32_t kind) {
+    m_il.ld_i4(kind);
+    m_il.emit_call(METHOD_CONSUME_GENERATOR);
+}
+
+void PythonCompiler::emit_consume_value() {
+    // The consumer is passed to the consumer variant in place of the unused first argument
+    Local value = emit_define_local(LK_NativeInt);
+    emit_store_local(value);
+    m_il.ld_arg(0);
+    emit_load_and_free_local(value);
+    m_il.emit_call(METHOD_CONSUMER_ACCEPT);
+}
+
+void PythonCompiler::emit_getiter_sequence(Local index, Local size, AbstractValueWithSources iterable) {
+    // The list or tuple stays on the stack in place of an iterator, FOR_ITER walks it with index
+    Label passedGuard, done;
+    if (iterable.Value->needsGuard()) {
+        passedGuard = emit_define_label(), done = emit_define_label();
+        m_il.dup();
+        LD_FIELDI(PyObject, ob_type);
+        emit_ptr(iterable.Value->pythonType());
+        emit_branch(BranchEqual, passedGuard);
+        // A negative index tells FOR_ITER there is a real iterator on the stack
+        emit_getiter();
+        m_il.ld_i(-1);
+        emit_store_local(index);
+        emit_branch(BranchAlways, done);
+        emit_mark_label(passedGuard);
+    }
+
+    emit_sizet(0);
+    emit_store_local(index);
+    if (iterable.Value->kind() == AVK_Tuple) {
+        m_il.dup();
+        emit_tuple_length();
+        emit_store_local(size);
+    }
+
+    if (iterable.Value->needsGuard()) {
+        emit_mark_label(done);
+    }
+}
+
+void PythonCompiler::emit_for_next_sequence(Local index, Local size, AbstractValueWithSources iterable) {
+    Label stopIter = emit_define_label(), done = emit_define_label();
+    if (iterable.Value->needsGuard()) {
+        auto inlined = emit_define_label();
+        emit_load_local(index);
+        m_il.ld_i(-1);
+        emit_branch(BranchNotEqual, inlined);
+        emit_for_next();
+        emit_branch(BranchAlways, done);
+        emit_mark_label(inlined);
+    }
+
+    Local sequence = emit_define_local(LK_NativeInt);
+    emit_store_local(sequence);
+
+    emit_load_local(index);
+    if (iterable.Value->kind() == AVK_List) {
+        // The loop body can resize the list, so like listiterator the size is read on every step
+        emit_load_local(sequence);
+        emit_list_length();
+    } else {
+        emit_load_local(size);
+    }
+    emit_branch(BranchGreaterThanEqual, stopIter);
+
+    emit_load_local(sequence);
+    if (iterable.Value->kind() == AVK_List) {
+        LD_FIELDI(PyListObject, ob_item);
+    } else {
+        emit_sizet(offsetof(PyTupleObject, ob_item));
+        m_il.add();
+    }
+    emit_load_local(index);
+    emit_sizet(sizeof(PyObject*));
+    m_il.mul();
+    m_il.add();
+    m_il.ld_ind_i();
+    m_il.dup();
+    emit_incref();
+    emit_inc_local(index, 1);
+    emit_branch(BranchAlways, done);
+
+    emit_mark_label(stopIter);
+    emit_ptr((void*) SIG_STOP_ITER);
+
+    emit_mark_label(done);
+    emit_free_local(sequence);
+}
+
 void PythonCompiler::emit_debug_msg(const char* msg) {
 #ifdef DEBUG_VERBOSE
     m_il.ld_i((void*) msg);
@@ -2125,7 +2431,7 @@ void PythonCompiler::emit_init_instr_counter() {
     emit_store_local(m_instrCount);
 }
 
-void PythonCompiler::emit_pending_calls() {
+void PythonCompiler::emit_pending_calls(const vector<Local>& invalidated) {
     Label skipPending = emit_define_label();
     m_il.ld_loc(m_instrCount);
     m_il.load_one();
@@ -2137,6 +2443,10 @@ void PythonCompiler::emit_pending_calls() {
     emit_branch(BranchTrue, skipPending);
     m_il.emit_call(METHOD_PENDING_CALLS);
     m_il.pop();// TODO : Handle error from Py_MakePendingCalls?
+    for (auto& local : invalidated) {
+        emit_int(0);
+        emit_store_local(local);
+    }
     emit_mark_label(skipPending);
 }
 
@@ -2356,6 +2666,13 @@ void PythonCompiler::emit_call_function_inline(py_oparg n_args, AbstractValueWit
 
 JittedCode* PythonCompiler::emit_compile() {
     auto* jitInfo = new CorJitInfo(PyUnicode_AsUTF8(m_code->co_filename), PyUnicode_AsUTF8(m_code->co_name), m_module, m_compileDebug);
+    if (m_deferNativeCompile) {
+        // Everything that reads the code object is done here, compile_native only needs the IL.
+        delete m_pendingJitInfo;
+        m_pendingJitInfo = jitInfo;
+        m_pendingStackSize = m_code->co_stacksize + 100;
+        return jitInfo;
+    }
     auto addr = m_il.compile(jitInfo, g_jit, m_code->co_stacksize + 100).m_addr;
     if (addr == nullptr) {
 #ifdef REPORT_CLR_FAULTS
@@ -2370,6 +2687,18 @@ JittedCode* PythonCompiler::emit_compile() {
     return jitInfo;
 }
 
+JittedCode* PythonCompiler::compile_native() {
+    auto* jitInfo = m_pendingJitInfo;
+    if (jitInfo == nullptr)
+        return nullptr;
+    if (m_il.compile(jitInfo, g_jit, m_pendingStackSize).m_addr == nullptr) {
+        // Left pending, it owns objects from CPython's allocator so is freed by the destructor, under the GIL.
+        return nullptr;
+    }
+    m_pendingJitInfo = nullptr;
+    return jitInfo;
+}
+
 void PythonCompiler::mark_sequence_point(size_t idx) {
     m_il.mark_sequence_point(idx);
 }
@@ -2422,13 +2751,13 @@ LocalKind PythonCompiler::emit_unboxed_binary_subscr(AbstractValueWithSources le
 void PythonCompiler::emit_box(AbstractValueKind kind) {
     switch (kind) {
         case AVK_Float:
-            m_il.emit_call(METHOD_FLOAT_FROM_DOUBLE);
+            emit_box_float();
             break;
         case AVK_Bool:
-            m_il.emit_call(METHOD_BOOL_FROM_LONG);
+            emit_box_bool();
             break;
         case AVK_Integer:
-            m_il.emit_call(METHOD_PYLONG_FROM_LONGLONG);
+            emit_box_int();
             break;
         case AVK_Range:
         case AVK_UnboxedRangeIterator:
@@ -2440,6 +2769,104 @@ void PythonCompiler::emit_box(AbstractValueKind kind) {
             throw UnexpectedValueException();
     }
 };
+void PythonCompiler::emit_box_float() {
+    // Takes an object from the interpreter's freelist and sets its header, PyJit_FloatFromDouble refills the freelist
+    // when it's empty
+    auto freeList = &PyJit_InterpreterState()->floatFreeList;
+    Local value = emit_define_local(LK_Float), count = emit_define_local(LK_NativeInt), result = emit_define_local(LK_Pointer);
+    Label refill = emit_define_label(), done = emit_define_label();
+    emit_store_local(value);
+    emit_ptr(freeList);
+    LD_FIELDI(PyJitFloatFreeList, count);
+    emit_store_local(count);
+    emit_load_local(count);
+    m_il.load_null();
+    emit_branch(BranchEqual, refill);
+
+    emit_ptr(freeList);
+    LD_FIELDA(PyJitFloatFreeList, count);
+    emit_load_local(count);
+    m_il.load_one();
+    m_il.sub();
+    emit_store_local(count);
+    emit_load_local(count);
+    m_il.st_ind_i();
+
+    emit_ptr(&freeList->items);
+    emit_load_local(count);
+    emit_sizet(sizeof(PyObject*));
+    m_il.mul();
+    m_il.add();
+    m_il.ld_ind_i();
+    emit_store_local(result);
+
+    emit_load_local(result);
+    LD_FIELDA(PyObject, ob_refcnt);
+    m_il.load_one();
+    m_il.st_ind_i();
+    emit_load_local(result);
+    LD_FIELDA(PyObject, ob_type);
+    emit_ptr(&PyFloat_Type);
+    m_il.st_ind_i();
+    emit_load_local(result);
+    LD_FIELDA(PyFloatObject, ob_fval);
+    emit_load_local(value);
+    m_il.st_ind_r8();
+    emit_load_local(result);
+    emit_branch(BranchAlways, done);
+
+    emit_mark_label(refill);
+    emit_load_local(value);
+    m_il.emit_call(METHOD_FLOAT_FROM_DOUBLE);
+    emit_mark_label(done);
+    emit_free_local(value);
+    emit_free_local(count);
+    emit_free_local(result);
+}
+
+void PythonCompiler::emit_box_int() {
+    // Ints in the interpreter's small int range are taken from its table, others are allocated
+    Local value = emit_define_local(LK_Int);
+    Label allocate = emit_define_label(), done = emit_define_label();
+    emit_store_local(value);
+    emit_load_local(value);
+    m_il.ld_i8(-PYJIT_SMALL_INT_MIN);
+    m_il.add();
+    m_il.ld_i8(PYJIT_SMALL_INT_MAX - PYJIT_SMALL_INT_MIN);
+    emit_branch(BranchGreaterThanEqualUnsigned, allocate);
+
+    emit_ptr(PyJit_InterpreterState()->smallInts);
+    emit_load_local(value);
+    m_il.ld_i8(-PYJIT_SMALL_INT_MIN);
+    m_il.add();
+    m_il.conv_i();
+    emit_sizet(sizeof(PyObject*));
+    m_il.mul();
+    m_il.add();
+    m_il.ld_ind_i();
+    m_il.dup();
+    emit_incref();
+    emit_branch(BranchAlways, done);
+
+    emit_mark_label(allocate);
+    emit_load_local(value);
+    m_il.emit_call(METHOD_PYLONG_FROM_LONGLONG);
+    emit_mark_label(done);
+    emit_free_local(value);
+}
+
+void PythonCompiler::emit_box_bool() {
+    Label isFalse = emit_define_label(), done = emit_define_label();
+    emit_branch(BranchFalse, isFalse);
+    emit_ptr(Py_True);
+    emit_branch(BranchAlways, done);
+    emit_mark_label(isFalse);
+    emit_ptr(Py_False);
+    emit_mark_label(done);
+    m_il.dup();
+    emit_incref();
+}
+
 void PythonCompiler::emit_compare_unboxed(uint16_t compareType, AbstractValueWithSources left, AbstractValueWithSources right) {
 #ifdef DEBUG
     assert(supportsEscaping(left.Value->kind()) && supportsEscaping(right.Value->kind()));
@@ -2657,6 +3084,304 @@ void PythonCompiler::emit_nan_long() {
     m_il.ld_i8(MAXLONG);
 }
 
+void PythonCompiler::emit_int_to_float() {
+    m_il.conv_r8();
+}
+
+void PythonCompiler::emit_float_to_int() {
+    m_il.conv_i8();
+}
+
+void PythonCompiler::emit_float_to_int_object() {
+    m_il.emit_call(METHOD_PYLONG_FROM_DOUBLE);
+}
+
+void PythonCompiler::emit_check_math_method(PyMethodDef* def) {
+    m_il.ld_i(def);
+    m_il.emit_call(METHOD_CHECK_MATH_METHOD);
+}
+
+void PythonCompiler::emit_math_function(const NativeMathFunction* function) {
+    auto token = g_module.AddMethod(CORINFO_TYPE_DOUBLE,
+                                    vector<Parameter>{Parameter(CORINFO_TYPE_DOUBLE)},
+                                    (void*) function->function,
+                                    function->name);
+    m_il.emit_call(token);
+}
+
+void PythonCompiler::emit_math_result_check(const NativeMathFunction* function) {
+    Local result = emit_define_local(LK_Float);
+    emit_store_local(result);
+    if (function->returnsInt) {
+        // -2**63 <= result < 2**63, false for NaN
+        emit_load_local(result);
+        m_il.ld_r8(-9223372036854775808.0);
+        m_il.compare_ge_float();
+        emit_load_local(result);
+        m_il.ld_r8(9223372036854775808.0);
+        m_il.compare_lt();
+        m_il.bitwise_and();
+    } else {
+        // result - result is 0 unless result is infinite or NaN
+        emit_load_local(result);
+        emit_load_local(result);
+        m_il.sub();
+        m_il.ld_r8(0);
+        m_il.compare_eq();
+    }
+    emit_free_local(result);
+}
+
+void PythonCompiler::emit_math_error(const NativeMathFunction* function) {
+    m_il.ld_i((void*) function);
+    m_il.emit_call(METHOD_MATH_ERROR);
+}
+
+void PythonCompiler::emit_len(Local container, AbstractValueWithSources value, Label fallback) {
+    if (value.Value->needsGuard()) {
+        emit_load_local(container);
+        LD_FIELDI(PyObject, ob_type);
+        emit_ptr(value.Value->pythonType());
+        emit_branch(BranchNotEqual, fallback);
+    }
+    emit_load_local(container);
+    switch (value.Value->kind()) {
+        case AVK_Dict:
+            LD_FIELDI(PyDictObject, ma_used);
+            break;
+        case AVK_Set:
+            LD_FIELDI(PySetObject, used);
+            break;
+        case AVK_String:
+            LD_FIELDI(PyASCIIObject, length);
+            break;
+        case AVK_List:
+        case AVK_Tuple:
+        case AVK_Bytes:
+            LD_FIELDI(PyVarObject, ob_size);
+            break;
+        default:
+            throw UnexpectedValueException();
+    }
+    m_il.conv_i8();
+}
+
+void PythonCompiler::emit_unboxed_abs(AbstractValueKind kind) {
+    switch (kind) {
+        case AVK_Float: {
+            auto token = g_module.AddMethod(CORINFO_TYPE_DOUBLE,
+                                            vector<Parameter>{Parameter(CORINFO_TYPE_DOUBLE)},
+                                            (void*) static_cast<double (*)(double)>(fabs),
+                                            "fabs");
+            m_il.emit_call(token);
+            break;
+        }
+        case AVK_Integer: {
+            Local value = emit_define_local(LK_Int);
+            Label positive = emit_define_label(), done = emit_define_label();
+            emit_store_local(value);
+            emit_load_local(value);
+            m_il.ld_i8(0);
+            emit_branch(BranchGreaterThanEqual, positive);
+            emit_load_local(value);
+            m_il.neg();
+            emit_branch(BranchAlways, done);
+            emit_mark_label(positive);
+            emit_load_local(value);
+            emit_mark_label(done);
+            emit_free_local(value);
+            break;
+        }
+        default:
+            throw UnexpectedValueException();
+    }
+}
+
+void PythonCompiler::emit_complex_abs(Local complex, AbstractValueWithSources value, Label fallback) {
+    // hypot() of the Py_complex as complex's own abs, which is left to raise OverflowError and handle infinity and NaN
+    if (value.Value->needsGuard()) {
+        emit_load_local(complex);
+        LD_FIELDI(PyObject, ob_type);
+        emit_ptr(value.Value->pythonType());
+        emit_branch(BranchNotEqual, fallback);
+    }
+    Local result = emit_define_local(LK_Float);
+    auto token = g_module.AddMethod(CORINFO_TYPE_DOUBLE,
+                                    vector<Parameter>{Parameter(CORINFO_TYPE_DOUBLE), Parameter(CORINFO_TYPE_DOUBLE)},
+                                    (void*) static_cast<double (*)(double, double)>(hypot),
+                                    "hypot");
+    emit_load_local(complex);
+    LD_FIELDR8(PyComplexObject, cval.real);
+    emit_load_local(complex);
+    LD_FIELDR8(PyComplexObject, cval.imag);
+    m_il.emit_call(token);
+    emit_store_local(result);
+    // result - result is 0 unless result is infinite or NaN
+    emit_load_local(result);
+    emit_load_local(result);
+    m_il.sub();
+    m_il.ld_r8(0);
+    m_il.compare_eq();
+    emit_branch(BranchFalse, fallback);
+    emit_load_and_free_local(result);
+}
+
+void PythonCompiler::emit_unboxed_min_max(AbstractValueKind kind, bool isMax) {
+    // As the builtins, the second value is only taken if it compares less (or greater), so NaN keeps the first
+    Local first = emit_define_local(kind), second = emit_define_local(kind);
+    Label takeSecond = emit_define_label(), done = emit_define_label();
+    emit_store_local(second);
+    emit_store_local(first);
+    emit_load_local(second);
+    emit_load_local(first);
+    emit_branch(isMax ? BranchGreaterThan : BranchLessThan, takeSecond);
+    emit_load_local(first);
+    emit_branch(BranchAlways, done);
+    emit_mark_label(takeSecond);
+    emit_load_local(second);
+    emit_mark_label(done);
+    emit_free_local(first);
+    emit_free_local(second);
+}
+
+void PythonCompiler::emit_isinstance(PyTypeObject* type) {
+    // The exact type, or a subclass with the type's flag set, is an instance without a call
+    unsigned long subclassFlag = 0;
+    if (type == &PyLong_Type)
+        subclassFlag = Py_TPFLAGS_LONG_SUBCLASS;
+    else if (type == &PyUnicode_Type)
+        subclassFlag = Py_TPFLAGS_UNICODE_SUBCLASS;
+    else if (type == &PyBytes_Type)
+        subclassFlag = Py_TPFLAGS_BYTES_SUBCLASS;
+    else if (type == &PyList_Type)
+        subclassFlag = Py_TPFLAGS_LIST_SUBCLASS;
+    else if (type == &PyTuple_Type)
+        subclassFlag = Py_TPFLAGS_TUPLE_SUBCLASS;
+    else if (type == &PyDict_Type)
+        subclassFlag = Py_TPFLAGS_DICT_SUBCLASS;
+
+    Local obj = emit_define_local(LK_Pointer);
+    Label isInstance = emit_define_label(), done = emit_define_label();
+    emit_store_local(obj);
+    emit_load_local(obj);
+    LD_FIELDI(PyObject, ob_type);
+    emit_ptr(type);
+    emit_branch(BranchEqual, isInstance);
+    if (subclassFlag != 0) {
+        emit_load_local(obj);
+        LD_FIELDI(PyObject, ob_type);
+        LD_FIELDA(PyTypeObject, tp_flags);
+        m_il.ld_ind_i4();
+        m_il.ld_i4((int32_t) subclassFlag);
+        m_il.bitwise_and();
+        emit_branch(BranchTrue, isInstance);
+    }
+    // Anything else could still be an instance through __class__
+    auto isinstance_token = g_module.AddMethod(CORINFO_TYPE_INT,
+                                               vector<Parameter>{
+                                                       Parameter(CORINFO_TYPE_NATIVEINT),
+                                                       Parameter(CORINFO_TYPE_NATIVEINT)},
+                                               (void*) PyObject_IsInstance,
+                                               "PyObject_IsInstance");
+    emit_load_local(obj);
+    emit_ptr(type);
+    m_il.emit_call(isinstance_token);
+    emit_branch(BranchAlways, done);
+    emit_mark_label(isInstance);
+    m_il.ld_i4(1);
+    emit_mark_label(done);
+    emit_free_local(obj);
+}
+
+void PythonCompiler::emit_float_in_int_range() {
+    // Both comparisons are false for NaN. -2**63 and 2**63 are exact doubles, anything in between truncates in range
+    Local value = emit_define_local(LK_Float);
+    emit_store_local(value);
+    emit_load_local(value);
+    m_il.ld_r8(-9223372036854775808.0);
+    m_il.compare_ge_float();
+    emit_load_local(value);
+    m_il.ld_r8(9223372036854775808.0);
+    m_il.compare_lt();
+    m_il.bitwise_and();
+    emit_free_local(value);
+}
+
+void PythonCompiler::emit_unboxed_to_int(AbstractValueKind kind) {
+    switch (kind) {
+        case AVK_Integer:
+            break;
+        case AVK_Bool:
+        case AVK_Float:
+            m_il.conv_i8();
+            break;
+        default:
+            throw UnexpectedValueException();
+    }
+}
+
+void PythonCompiler::emit_unboxed_to_bool(AbstractValueKind kind) {
+    switch (kind) {
+        case AVK_Bool:
+            break;
+        case AVK_Integer:
+            m_il.ld_i8(0);
+            m_il.compare_ne();
+            break;
+        case AVK_Float:
+            // NaN is true
+            m_il.ld_r8(0.0);
+            m_il.compare_ne();
+            break;
+        default:
+            throw UnexpectedValueException();
+    }
+}
+
+void PythonCompiler::emit_unboxed_int_to_str() {
+    m_il.emit_call(METHOD_UNBOXED_INT_TO_STRING);
+}
+
+void PythonCompiler::emit_call_direct(py_oparg nargs, int32_t argKinds, AbstractValueKind kind, Local result) {
+    // Unused arguments are passed as NULL
+    for (py_oparg i = nargs; i < DIRECT_CALL_MAX_ARGS; i++) {
+        emit_null();
+    }
+    m_il.ld_i4((int32_t) nargs);
+    m_il.ld_i4(argKinds);
+    m_il.ld_i4(kind);
+    emit_load_local_addr(result);
+    m_il.emit_call(METHOD_CALL_DIRECT);
+}
+
+void PythonCompiler::emit_unboxed_return(AbstractValueKind kind) {
+    // The direct variant gets its PyjionDirectCall in place of the first argument
+    Local value = emit_define_local(kind);
+    emit_store_local(value);
+    m_il.ld_arg(0);
+    LD_FIELDA(PyjionDirectCall, returnValue);
+    emit_load_and_free_local(value);
+    if (kind == AVK_Float)
+        m_il.st_ind_r8();
+    else
+        m_il.st_ind_i8();
+    m_il.ld_arg(0);
+    LD_FIELDA(PyjionDirectCall, returnKind);
+    m_il.ld_i4(kind);
+    m_il.st_ind_i4();
+    emit_ptr((void*) SIG_UNBOXED_RETURN);
+}
+
+void PythonCompiler::emit_load_direct_arg(size_t arg, AbstractValueKind kind) {
+    m_il.ld_arg(0);
+    emit_sizet(offsetof(PyjionDirectCall, args) + arg * sizeof(PyjionDirectValue));
+    m_il.add();
+    if (kind == AVK_Float)
+        m_il.ld_ind_r8();
+    else
+        m_il.ld_ind_i8();
+}
+
 void PythonCompiler::emit_escape_edges(vector<Edge> edges, Local success) {
     emit_int(0);
     emit_store_local(success);// Will get set to 1 on unbox failures.
@@ -2719,6 +3444,7 @@ GLOBAL_METHOD(METHOD_SUBSCR_DICT, &PyJit_SubscrDict, CORINFO_TYPE_NATIVEINT, Par
 GLOBAL_METHOD(METHOD_SUBSCR_DICT_HASH, &PyJit_SubscrDictHash, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_SUBSCR_LIST, &PyJit_SubscrList, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_SUBSCR_LIST_I, &PyJit_SubscrListIndex, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_SUBSCR_LIST_UNBOXED, &PyJit_SubscrListUnboxedIndex, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_LONG));
 GLOBAL_METHOD(METHOD_SUBSCR_LIST_SLICE, &PyJit_SubscrListSlice, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_SUBSCR_LIST_SLICE_STEPPED, &PyJit_SubscrListSliceStepped, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_SUBSCR_LIST_SLICE_REVERSED, &PyJit_SubscrListReversed, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
@@ -2821,6 +3547,16 @@ GLOBAL_METHOD(METHOD_GETITER_TOKEN, &PyJit_GetIter, CORINFO_TYPE_NATIVEINT, Para
 GLOBAL_METHOD(METHOD_GET_UNBOXED_ITER, &PyJit_GetUnboxedIter, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_FORITER, &PyJit_IterNext, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_FORITER_UNBOXED, &PyJit_IterNextUnboxed, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_UNPACK_ITER_NEW, &PyJit_UnpackIterNew, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_INT), Parameter(CORINFO_TYPE_INT));
+GLOBAL_METHOD(METHOD_UNPACK_ITER_NEXT, &PyJit_UnpackIterNext, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_GET_UNPACK_ITER, &PyJit_GetUnpackIter, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_INT));
+GLOBAL_METHOD(METHOD_CONSUME_GENERATOR, &PyJit_ConsumeGenerator, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_INT));
+GLOBAL_METHOD(METHOD_CONSUMER_ACCEPT, &PyJit_ConsumerAccept, CORINFO_TYPE_INT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_NEW_COMPREHENSION_LIST, &PyJit_NewComprehensionList, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_NEW_COMPREHENSION_DICT, &PyJit_NewComprehensionDict, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_TRIM_LIST, &PyJit_TrimList, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_COMPLEX_BINARY_OP, &PyJit_ComplexBinaryOp, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_INT));
+GLOBAL_METHOD(METHOD_LOAD_COMPLEX_PART, &PyJit_LoadComplexPart, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_INT));
 
 GLOBAL_METHOD(METHOD_DECREF_TOKEN, &PyJit_DecRef, CORINFO_TYPE_VOID, Parameter(CORINFO_TYPE_NATIVEINT));
 
@@ -2902,11 +3638,12 @@ GLOBAL_METHOD(METHOD_INT_TRUE_DIVIDE, PyJit_LongTrueDivide, CORINFO_TYPE_DOUBLE,
 GLOBAL_METHOD(METHOD_INT_MOD, PyJit_LongMod, CORINFO_TYPE_LONG, Parameter(CORINFO_TYPE_LONG), Parameter(CORINFO_TYPE_LONG));
 
 GLOBAL_METHOD(METHOD_FLOAT_MODULUS_TOKEN, static_cast<double (*)(double, double)>(fmod), CORINFO_TYPE_DOUBLE, Parameter(CORINFO_TYPE_DOUBLE), Parameter(CORINFO_TYPE_DOUBLE));
-GLOBAL_METHOD(METHOD_FLOAT_FROM_DOUBLE, PyFloat_FromDouble, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_DOUBLE));
+GLOBAL_METHOD(METHOD_FLOAT_FROM_DOUBLE, PyJit_FloatFromDouble, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_DOUBLE));
 GLOBAL_METHOD(METHOD_BOOL_FROM_LONG, PyBool_FromLong, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_INT));
 GLOBAL_METHOD(METHOD_NUMBER_AS_SSIZET, PyNumber_AsSsize_t, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_PYLONG_AS_LONGLONG, PyJit_LongAsLongLong, CORINFO_TYPE_LONG, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_PYLONG_FROM_LONGLONG, PyLong_FromLongLong, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_LONG));
+GLOBAL_METHOD(METHOD_PYLONG_FROM_DOUBLE, PyLong_FromDouble, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_DOUBLE));
 
 GLOBAL_METHOD(METHOD_PYERR_SETSTRING, PyErr_SetString, CORINFO_TYPE_VOID, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
 
@@ -2958,6 +3695,11 @@ GLOBAL_METHOD(METHOD_GIL_RELEASE, &PyGILState_Release, CORINFO_TYPE_VOID, Parame
 GLOBAL_METHOD(METHOD_BLOCK_POP, &PyJit_BlockPop, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_NATIVEINT));
 GLOBAL_METHOD(METHOD_BLOCK_PUSH, &PyFrame_BlockSetup, CORINFO_TYPE_VOID, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_INT), Parameter(CORINFO_TYPE_INT), Parameter(CORINFO_TYPE_INT));
 GLOBAL_METHOD(METHOD_UNBOX_BOOL, &PyJit_UnboxBool, CORINFO_TYPE_BYTE, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_CHECK_MATH_METHOD, &PyJit_CheckMathMethod, CORINFO_TYPE_INT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_MATH_ERROR, &PyJit_MathError, CORINFO_TYPE_INT, Parameter(CORINFO_TYPE_DOUBLE), Parameter(CORINFO_TYPE_DOUBLE), Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_UNBOXED_INT_TO_STRING, &PyJit_UnboxedIntToString, CORINFO_TYPE_NATIVEINT, Parameter(CORINFO_TYPE_LONG));
+GLOBAL_METHOD(METHOD_RANGE_INDEXES_LIST, &PyJit_RangeIndexesList, CORINFO_TYPE_INT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT));
+GLOBAL_METHOD(METHOD_CALL_DIRECT, &PyJit_CallDirect, CORINFO_TYPE_INT, Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_NATIVEINT), Parameter(CORINFO_TYPE_INT), Parameter(CORINFO_TYPE_INT), Parameter(CORINFO_TYPE_INT), Parameter(CORINFO_TYPE_NATIVEINT));
 
 GLOBAL_INTRINSIC(INTRINSIC_TEST, &PyJit_LongTrueDivide, CORINFO_TYPE_DOUBLE, Parameter(CORINFO_TYPE_LONG), Parameter(CORINFO_TYPE_LONG));
 
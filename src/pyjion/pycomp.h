@@ -122,6 +122,10 @@
 #define METHOD_ISNOT_BOOL                    0x0000004C
 #define METHOD_HANDLE_EXCEPTION              0x0000004D
 #define METHOD_FORITER                       0x0000004E
+#define METHOD_UNPACK_ITER_NEW               0x0000004F
+#define METHOD_UNPACK_ITER_NEXT              0x00000050
+#define METHOD_GET_UNPACK_ITER               0x00000051
+#define METHOD_CONSUME_GENERATOR             0x00000052
 
 #define METHOD_FLOAT_FROM_DOUBLE             0x00000053
 #define METHOD_BOOL_FROM_LONG                0x00000054
@@ -129,6 +133,12 @@
 #define METHOD_NUMBER_AS_SSIZET              0x00000056
 #define METHOD_PYLONG_AS_LONGLONG            0x00000057
 #define METHOD_PYLONG_FROM_LONGLONG          0x00000058
+#define METHOD_CONSUMER_ACCEPT               0x00000059
+#define METHOD_NEW_COMPREHENSION_LIST        0x0000005A
+#define METHOD_NEW_COMPREHENSION_DICT        0x0000005B
+#define METHOD_TRIM_LIST                     0x0000005C
+#define METHOD_COMPLEX_BINARY_OP             0x0000005D
+#define METHOD_LOAD_COMPLEX_PART             0x0000005E
 
 #define METHOD_EXTENDLIST_TOKEN              0x0000006C
 #define METHOD_LISTTOTUPLE_TOKEN             0x0000006D
@@ -228,6 +238,13 @@
 #define METHOD_INT_TRUE_DIVIDE               0x00050005
 #define METHOD_INT_MOD                       0x00050006
 #define METHOD_UNBOX_BOOL                    0x00050007
+#define METHOD_CHECK_MATH_METHOD             0x00050008
+#define METHOD_MATH_ERROR                    0x00050009
+#define METHOD_UNBOXED_INT_TO_STRING         0x0005000A
+#define METHOD_CALL_DIRECT                   0x0005000B
+#define METHOD_SUBSCR_LIST_UNBOXED           0x0005000C
+#define METHOD_RANGE_INDEXES_LIST            0x0005000D
+#define METHOD_PYLONG_FROM_DOUBLE            0x0005000E
 
 #define METHOD_STORE_SUBSCR_OBJ              0x00060000
 #define METHOD_STORE_SUBSCR_OBJ_I            0x00060001
@@ -281,9 +298,20 @@ class PythonCompiler : public IPythonCompiler {
     Local m_lasti;
     Local m_instrCount;
     bool m_compileDebug;
+    // Set by defer_native_compile, emit_compile then leaves the clrjit call to compile_native
+    bool m_deferNativeCompile = false;
+    CorJitInfo* m_pendingJitInfo = nullptr;
+    int m_pendingStackSize = 0;
 
 public:
     explicit PythonCompiler(PyCodeObject* code);
+    ~PythonCompiler();
+
+    /* Split emit_compile, only the IL is generated and the native compilation is left to compile_native */
+    void defer_native_compile();
+    /* Run clrjit over the IL generated by a deferred emit_compile. Does not touch Python objects, so it can be
+     * called from a thread which doesn't hold the GIL. Returns nullptr if the compilation failed. */
+    JittedCode* compile_native();
 
     void emit_rot_two(LocalKind kind) override;
 
@@ -420,6 +448,9 @@ public:
     void emit_set_add() override;
     void emit_map_add() override;
     void emit_list_append() override;
+    void emit_new_comprehension_list() override;
+    void emit_new_comprehension_dict() override;
+    void emit_trim_list() override;
 
     void emit_raise_varargs() override;
 
@@ -430,6 +461,15 @@ public:
     void emit_getiter_unboxed() override;
     void emit_for_next() override;
     void emit_for_next_unboxed() override;
+    void emit_getiter_sequence(Local index, Local size, AbstractValueWithSources iterable) override;
+    void emit_for_next_sequence(Local index, Local size, AbstractValueWithSources iterable) override;
+    void emit_unpack_iter_new(py_oparg width, bool unboxedCounter) override;
+    void emit_getiter_unpack(py_oparg width) override;
+    void emit_for_next_unpack() override;
+    void emit_unpack_iter(py_oparg size, AbstractValueWithSources iterable) override;
+    void emit_unpack_enumerate(Label generic) override;
+    void emit_consume_generator(int32_t kind) override;
+    void emit_consume_value() override;
 
     LocalKind emit_binary_float(uint16_t opcode) override;
     LocalKind emit_binary_int(uint16_t opcode) override;
@@ -439,6 +479,8 @@ public:
     void emit_binary_subscr() override;
     void emit_binary_subscr(AbstractValueWithSources left, AbstractValueWithSources right) override;
     LocalKind emit_unboxed_binary_subscr(AbstractValueWithSources left, AbstractValueWithSources right) override;
+    void emit_list_index(Local inBounds) override;
+    void emit_range_indexes_lists(const vector<py_oparg>& lists, Local guard) override;
     bool emit_binary_subscr_slice(AbstractValueWithSources container, AbstractValueWithSources start, AbstractValueWithSources stop) override;
     bool emit_binary_subscr_slice(AbstractValueWithSources container, AbstractValueWithSources start, AbstractValueWithSources stop, AbstractValueWithSources step) override;
 
@@ -497,7 +539,7 @@ public:
 
     void emit_load_assertion_error() override;
 
-    void emit_pending_calls() override;
+    void emit_pending_calls(const vector<Local>& invalidated) override;
     void emit_init_instr_counter() override;
 
     void emit_setup_annotations() override;
@@ -527,7 +569,26 @@ public:
     void emit_nan() override;
     void emit_infinity_long() override;
     void emit_nan_long() override;
+    void emit_int_to_float() override;
+    void emit_float_to_int() override;
+    void emit_float_to_int_object() override;
     void emit_guard_exception(const char* expected) override;
+    void emit_check_math_method(PyMethodDef* def) override;
+    void emit_math_function(const NativeMathFunction* function) override;
+    void emit_math_result_check(const NativeMathFunction* function) override;
+    void emit_math_error(const NativeMathFunction* function) override;
+    void emit_len(Local container, AbstractValueWithSources value, Label fallback) override;
+    void emit_unboxed_abs(AbstractValueKind kind) override;
+    void emit_complex_abs(Local complex, AbstractValueWithSources value, Label fallback) override;
+    void emit_unboxed_min_max(AbstractValueKind kind, bool isMax) override;
+    void emit_isinstance(PyTypeObject* type) override;
+    void emit_float_in_int_range() override;
+    void emit_unboxed_to_int(AbstractValueKind kind) override;
+    void emit_unboxed_to_bool(AbstractValueKind kind) override;
+    void emit_unboxed_int_to_str() override;
+    void emit_call_direct(py_oparg nargs, int32_t argKinds, AbstractValueKind kind, Local result) override;
+    void emit_unboxed_return(AbstractValueKind kind) override;
+    void emit_load_direct_arg(size_t arg, AbstractValueKind kind) override;
 
     void emit_store_in_frame_value_stack(uint32_t idx) override;
     void emit_load_from_frame_value_stack(uint32_t idx) override;
@@ -553,6 +614,9 @@ private:
     void emit_known_binary_op_multiply(AbstractValueWithSources& left, AbstractValueWithSources& right, Local leftLocal, Local rightLocal, int nb_slot,
                                        int sq_slot, int fallback_token);
     void fill_local_vector(vector<Local>& vec, size_t len);
+    void emit_box_float();
+    void emit_box_int();
+    void emit_box_bool();
 };
 
 const char* opcodeName(py_opcode opcode);
@@ -27,6 +27,11 @@
 #include "pyjit.h"
 #include "pycomp.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
 #ifdef WINDOWS
 #define BUFSIZE 65535
 #include <libloaderapi.h>
@@ -38,17 +43,62 @@ typedef void(__cdecl* JITSTARTUP)(ICorJitHost*);
 #define MAX_UINT8_T  255
 #define MAX_UINT16_T 65535
 
-PyjionSettings g_pyjionSettings;
-AttributeTable* g_attrTable;
 extern BaseModule g_module;
+
+// States by interpreter ID, IDs are never reused so they are safe to cache. Only accessed with the GIL held.
+static unordered_map<int64_t, PyjionInterpreterState*> g_interpreters;
+static thread_local int64_t t_interpreterId = -1;
+static thread_local PyjionInterpreterState* t_interpreterState = nullptr;
+
+static void PyJit_FreeInterpreterState(PyObject* capsule) {
+    auto id = (int64_t) (intptr_t) PyCapsule_GetContext(capsule);
+    auto state = g_interpreters.find(id);
+    if (state != g_interpreters.end()) {
+        PyJit_FreeBoxing(state->second);
+        delete state->second;
+        g_interpreters.erase(state);
+    }
+    if (t_interpreterId == id) {
+        t_interpreterId = -1;
+        t_interpreterState = nullptr;
+    }
+}
+
+PyjionInterpreterState* PyJit_InterpreterState() {
+    auto interp = PyInterpreterState_Get();
+    auto id = PyInterpreterState_GetID(interp);
+    if (id == t_interpreterId)
+        return t_interpreterState;
+
+    PyjionInterpreterState* state;
+    auto existing = g_interpreters.find(id);
+    if (existing != g_interpreters.end()) {
+        state = existing->second;
+    } else {
+        state = new PyjionInterpreterState();
+        g_interpreters[id] = state;
+        // The interpreter's dict is cleared when it is finalized, which frees the state with it
+        auto dict = PyInterpreterState_GetDict(interp);
+        auto capsule = PyCapsule_New(state, "pyjion.interpreter_state", PyJit_FreeInterpreterState);
+        if (dict != nullptr && capsule != nullptr && PyCapsule_SetContext(capsule, (void*) (intptr_t) id) == 0) {
+            PyDict_SetItemString(dict, "pyjion.interpreter_state", capsule);
+        }
+        Py_XDECREF(capsule);
+        PyErr_Clear();
+    }
+    t_interpreterId = id;
+    t_interpreterState = state;
+    return state;
+}
+
 #define SET_OPT(opt, actualLevel, minLevel)                                      \
     if ((actualLevel) >= (minLevel)) {                                           \
-        g_pyjionSettings.optimizations = g_pyjionSettings.optimizations | (opt); \
+        PyJit_Settings().optimizations = PyJit_Settings().optimizations | (opt); \
     }
 
 void setOptimizationLevel(unsigned short level) {
-    g_pyjionSettings.optimizationLevel = level;
-    g_pyjionSettings.optimizations = OptimizationFlags();
+    PyJit_Settings().optimizationLevel = level;
+    PyJit_Settings().optimizations = OptimizationFlags();
     SET_OPT(InlineIs, level, 1);
     SET_OPT(InlineDecref, level, 1);
     SET_OPT(InternRichCompare, level, 1);
@@ -72,7 +122,7 @@ PyjionJittedCode::~PyjionJittedCode() {
 }
 
 int Pyjit_CheckRecursiveCall(PyThreadState* tstate, const char* where) {
-    int recursion_limit = g_pyjionSettings.recursionLimit;
+    int recursion_limit = PyJit_Settings().recursionLimit;
 
     if (tstate->recursion_headroom) {
         if (tstate->recursion_depth > recursion_limit + 50) {
@@ -95,7 +145,7 @@ int Pyjit_CheckRecursiveCall(PyThreadState* tstate, const char* where) {
 
 static inline int Pyjit_EnterRecursiveCall(const char* where) {
     PyThreadState* tstate = PyThreadState_GET();
-    return ((++tstate->recursion_depth > g_pyjionSettings.recursionLimit) && Pyjit_CheckRecursiveCall(tstate, where));
+    return ((++tstate->recursion_depth > PyJit_Settings().recursionLimit) && Pyjit_CheckRecursiveCall(tstate, where));
 }
 
 static inline void Pyjit_LeaveRecursiveCall() {
@@ -114,7 +164,8 @@ PyJit_CheckFunctionResult(PyThreadState* tstate, PyObject* result, PyFrameObject
         }
     } else {
         if (PyErr_Occurred()) {
-            Py_DECREF(result);
+            if (result != (PyObject*) SIG_UNBOXED_RETURN)
+                Py_DECREF(result);
 
             _PyErr_FormatFromCause(PyExc_SystemError,
                                    "%s returned a result with an exception set", PyUnicode_AsUTF8(frame->f_code->co_name));
@@ -124,7 +175,7 @@ PyJit_CheckFunctionResult(PyThreadState* tstate, PyObject* result, PyFrameObject
     return result;
 }
 
-static inline PyObject* PyJit_ExecuteJittedFrame(void* state, PyFrameObject* frame, PyThreadState* tstate, PyjionJittedCode* jitted) {
+static inline PyObject* PyJit_ExecuteJittedFrame(void* state, PyFrameObject* frame, PyThreadState* tstate, PyjionJittedCode* jitted, void* context) {
     if (Pyjit_EnterRecursiveCall("")) {
         return nullptr;
     }
@@ -142,7 +193,7 @@ static inline PyObject* PyJit_ExecuteJittedFrame(void* state, PyFrameObject* fra
     frame->f_state = PY_FRAME_EXECUTING;
 
     try {
-        auto res = ((Py_EvalFunc) state)(nullptr, frame, tstate, jitted->j_profile, &trace_info);
+        auto res = ((Py_ContextEvalFunc) state)(context, frame, tstate, jitted->j_profile, &trace_info);
         tstate->cframe = trace_info.cframe.previous;
         tstate->cframe->use_tracing = trace_info.cframe.use_tracing;
         Pyjit_LeaveRecursiveCall();
@@ -157,21 +208,29 @@ static inline PyObject* PyJit_ExecuteJittedFrame(void* state, PyFrameObject* fra
     }
 }
 
-static Py_tss_t* g_extraSlot;
-
 #ifdef WINDOWS
 HMODULE GetClrJit() {
-    return LoadLibrary(g_pyjionSettings.clrjitpath);
+    return LoadLibrary(PyJit_Settings().clrjitpath);
 }
 #endif
 
 bool JitInit(const wchar_t* path) {
-    g_pyjionSettings = PyjionSettings();
-    g_pyjionSettings.recursionLimit = Py_GetRecursionLimit();
-    g_pyjionSettings.clrjitpath = path;
-    g_attrTable = new AttributeTable();
-    g_extraSlot = PyThread_tss_alloc();
-    PyThread_tss_create(g_extraSlot);
+    auto& settings = PyJit_Settings();
+    settings = PyjionSettings();
+    settings.recursionLimit = Py_GetRecursionLimit();
+    settings.clrjitpath = path;
+    setOptimizationLevel(1);
+
+    // Jitted code bakes in the addresses of these, so each interpreter has its own
+    auto state = PyJit_InterpreterState();
+    if (state->emptyTuple == nullptr && !PyJit_InitBoxing(state))
+        return false;
+    if (state->consumerFunctions.empty() && !PyJit_InitConsumers(state))
+        return false;
+
+    // clrjit and the types below are shared, they are only set up by the first interpreter
+    if (g_jit != nullptr)
+        return true;
 #ifdef WINDOWS
     auto clrJitHandle = GetClrJit();
     if (clrJitHandle == nullptr) {
@@ -200,50 +259,114 @@ bool JitInit(const wchar_t* path) {
 
     if (PyType_Ready(&PyJitMethodLocation_Type) < 0)
         return false;
-    g_emptyTuple = PyTuple_New(0);
-    setOptimizationLevel(1);
+    if (PyType_Ready(&PyjionUnpackIter_Type) < 0)
+        return false;
     return true;
 }
 
-PyObject* PyJit_ExecuteAndCompileFrame(PyjionJittedCode* state, PyFrameObject* frame, PyThreadState* tstate, PyjionCodeProfile* profile) {
-    // Compile and run the now compiled code...
-    PythonCompiler jitter((PyCodeObject*) state->j_code);
-    AbstractInterpreter interp((PyCodeObject*) state->j_code, &jitter);
-    int argCount = frame->f_code->co_argcount + frame->f_code->co_kwonlyargcount;
+static inline bool PyJit_PgcEnabled(PyjionJittedCode* state) {
+    return state->j_policy.pgc == -1 ? PyJit_Settings().pgc : state->j_policy.pgc == 1;
+}
 
-    // provide the interpreter information about the specialized types
-    for (int i = 0; i < argCount; i++) {
-        interp.setLocalType(i, frame->f_localsplus[i]);
+// Applies a function's policy to the interpreter's settings for the duration of a compilation, only the settings the
+// policy overrides are restored so changes made through pyjion.config() or pyjion.freeze() are kept.
+class PyjionPolicyScope {
+    PyjionSettings& m_settings;
+    bool m_overridesLevel;
+    bool m_overridesPgc;
+    uint8_t m_savedLevel;
+    OptimizationFlags m_savedOptimizations;
+    bool m_savedPgc;
+
+public:
+    explicit PyjionPolicyScope(PyjionJittedCode* state) : m_settings(PyJit_Settings()),
+                                                          m_overridesLevel(state->j_policy.level != -1),
+                                                          m_overridesPgc(state->j_policy.pgc != -1),
+                                                          m_savedLevel(m_settings.optimizationLevel),
+                                                          m_savedOptimizations(m_settings.optimizations),
+                                                          m_savedPgc(m_settings.pgc) {
+        if (m_overridesLevel)
+            setOptimizationLevel(state->j_policy.level);
+        if (m_overridesPgc)
+            m_settings.pgc = state->j_policy.pgc == 1;
     }
 
-    if (tstate->cframe->use_tracing && tstate->c_tracefunc) {
-        interp.enableTracing();
-        state->j_tracingHooks = true;
-    } else {
-        interp.disableTracing();
-        state->j_tracingHooks = false;
+    ~PyjionPolicyScope() {
+        if (m_overridesLevel) {
+            m_settings.optimizationLevel = m_savedLevel;
+            m_settings.optimizations = m_savedOptimizations;
+        }
+        if (m_overridesPgc)
+            m_settings.pgc = m_savedPgc;
     }
-    if (tstate->cframe->use_tracing && tstate->c_profilefunc) {
-        interp.enableProfiling();
-        state->j_profilingHooks = true;
-    } else {
-        interp.disableProfiling();
-        state->j_profilingHooks = false;
+};
+
+// fnmatch style matching, supports * and ?
+static bool PyJit_GlobMatch(const char* pattern, const char* text) {
+    const char* star = nullptr;
+    const char* resume = nullptr;
+    while (*text) {
+        if (*pattern == '?' || *pattern == *text) {
+            pattern++;
+            text++;
+        } else if (*pattern == '*') {
+            star = pattern++;
+            resume = text;
+        } else if (star != nullptr) {
+            pattern = star + 1;
+            text = ++resume;
+        } else {
+            return false;
+        }
     }
+    while (*pattern == '*')
+        pattern++;
+    return *pattern == '\0';
+}
 
-    auto res = interp.compile(frame->f_builtins, frame->f_globals, profile, state->j_pgc_status);
+// Matches the module the code runs in against the interpreter's module policies, unless a policy was set on the function.
+static void PyJit_ResolvePolicy(PyjionJittedCode* state, PyObject* globals) {
+    state->j_policyResolved = true;
+    auto& policies = PyJit_InterpreterState()->modulePolicies;
+    if (policies.empty() || !PyDict_Check(globals))
+        return;
+    auto name = PyDict_GetItemString(globals, "__name__");
+    if (name == nullptr || !PyUnicode_Check(name))
+        return;
+    auto moduleName = PyUnicode_AsUTF8(name);
+    if (moduleName == nullptr) {
+        PyErr_Clear();
+        return;
+    }
+    for (auto& policy : policies) {
+        if (PyJit_GlobMatch(policy.first.c_str(), moduleName)) {
+            state->j_policy = policy.second;
+            if (policy.second.threshold != -1)
+                state->j_specialization_threshold = policy.second.threshold;
+            return;
+        }
+    }
+}
+
+// Stores the result of a compilation on the jitted code, returns false if the compilation failed.
+static bool PyJit_UpdateJittedCode(PyjionJittedCode* state, AbstactInterpreterCompileResult& res, PyjionCodeProfile* profile) {
     state->j_compile_result = res.result;
     state->j_optimizations = res.optimizations;
-    if (g_pyjionSettings.graph) {
+    if (PyJit_Settings().graph) {
         if (state->j_graph != nullptr)
             Py_DECREF(state->j_graph);
         state->j_graph = res.instructionGraph;
     }
+    auto interpreterState = PyJit_InterpreterState();
     if (res.compiledCode == nullptr || res.result != Success) {
         state->j_failed = true;
         state->j_addr = nullptr;// TODO : Raise specific warning when it used to compile and then it didnt the second time.
-        return _PyEval_EvalFrameDefault(tstate, frame, 0);
+        interpreterState->failed++;
+        return false;
     }
+    interpreterState->compiled++;
+    interpreterState->ilBytes += res.compiledCode->get_il_len();
+    interpreterState->nativeBytes += res.compiledCode->get_native_size();
 
     // Update the jitted information for this tree node
     state->j_addr = (Py_EvalFunc) res.compiledCode->get_code_addr();
@@ -257,6 +380,248 @@ PyObject* PyJit_ExecuteAndCompileFrame(PyjionJittedCode* state, PyFrameObject* f
     state->j_sequencePointsLen = res.compiledCode->get_sequence_points_length();
     state->j_callPoints = res.compiledCode->get_call_points();
     state->j_callPointsLen = res.compiledCode->get_call_points_length();
+    return true;
+}
+
+// Analyses the code with the declared argument types and generates its IL, no PGC probes are emitted.
+static AbstactInterpreterCompileResult PyJit_CompileDeclared(PyjionJittedCode* state, PythonCompiler* jitter, PyObject* builtins, PyObject* globals, vector<PyTypeObject*>& argTypes) {
+    PyjionPolicyScope policy(state);
+    AbstractInterpreter interp((PyCodeObject*) state->j_code, jitter);
+    auto code = (PyCodeObject*) state->j_code;
+    size_t argCount = code->co_argcount + code->co_kwonlyargcount;
+
+    // declared types replace the values that would have been observed on the first frame
+    for (size_t i = 0; i < argTypes.size() && i < argCount; i++) {
+        interp.setLocalType(i, argTypes[i]);
+    }
+    interp.disableTracing();
+    interp.disableProfiling();
+
+    // No profile is passed, so no PGC probes are emitted and the code is final.
+    return interp.compile(builtins, globals, nullptr, Uncompiled);
+}
+
+static bool PyJit_InstallPrecompiled(PyjionJittedCode* state, AbstactInterpreterCompileResult& res) {
+    if (!PyJit_UpdateJittedCode(state, res, state->j_profile))
+        return false;
+    state->j_failed = false;
+    state->j_pgc_status = Optimized;
+    return true;
+}
+
+bool PyJit_PrecompileCode(PyjionJittedCode* state, PyObject* builtins, PyObject* globals, vector<PyTypeObject*>& argTypes) {
+    PythonCompiler jitter((PyCodeObject*) state->j_code);
+    auto res = PyJit_CompileDeclared(state, &jitter, builtins, globals, argTypes);
+    return PyJit_InstallPrecompiled(state, res);
+}
+
+vector<bool> PyJit_PrecompileBatch(vector<PyjionPrecompileRequest>& requests, size_t workers) {
+    struct Pending {
+        unique_ptr<PythonCompiler> compiler;
+        AbstactInterpreterCompileResult result;
+    };
+    vector<Pending> pending(requests.size());
+
+    // Abstract interpretation and IL generation read Python objects, they run here, serially, under the GIL.
+    for (size_t i = 0; i < requests.size(); i++) {
+        auto& request = requests[i];
+        if (!request.state->j_policy.enabled)
+            continue;
+        pending[i].compiler = std::make_unique<PythonCompiler>((PyCodeObject*) request.state->j_code);
+        pending[i].compiler->defer_native_compile();
+        pending[i].result = PyJit_CompileDeclared(request.state, pending[i].compiler.get(), request.builtins, request.globals, request.argTypes);
+    }
+
+    // clrjit only needs the IL and the method tokens, so the native compilation is spread over the workers.
+    // The GIL stays held while they run, so no other thread can register methods on g_module meanwhile.
+    std::atomic<size_t> next{0};
+    auto worker = [&pending, &next]() {
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            auto& item = pending[i];
+            if (item.result.result != Success || item.result.compiledCode == nullptr)
+                continue;
+            try {
+                item.result.compiledCode = item.compiler->compile_native();
+            } catch (const std::exception&) {
+                item.result.compiledCode = nullptr;
+            }
+            if (item.result.compiledCode == nullptr)
+                item.result.result = CompilationJitFailure;
+        }
+    };
+    vector<std::thread> threads;
+    for (size_t i = 1; i < workers && i < pending.size(); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    vector<bool> results(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        results[i] = requests[i].state->j_policy.enabled && PyJit_InstallPrecompiled(requests[i].state, pending[i].result);
+    }
+    return results;
+}
+
+static inline bool PyJit_HooksActive(PyThreadState* tstate) {
+    return tstate->cframe->use_tracing && (tstate->c_tracefunc != nullptr || tstate->c_profilefunc != nullptr);
+}
+
+// Compiles and runs the variant of the code with tracing and profiling hooks. The hook intrinsics check which
+// functions are set on each call, so one variant serves a tracer, a profiler or both, and they can be attached
+// and detached without recompiling either variant.
+static PyObject* PyJit_ExecuteAndCompileHookedFrame(PyjionJittedCode* state, PyFrameObject* frame, PyThreadState* tstate) {
+    AbstactInterpreterCompileResult res;
+    {
+        // The policy only applies while compiling, not to the callees compiled while the frame runs
+        PyjionPolicyScope policy(state);
+        PythonCompiler jitter((PyCodeObject*) state->j_code);
+        AbstractInterpreter interp((PyCodeObject*) state->j_code, &jitter);
+        int argCount = frame->f_code->co_argcount + frame->f_code->co_kwonlyargcount;
+
+        for (int i = 0; i < argCount; i++) {
+            interp.setLocalType(i, frame->f_localsplus[i]);
+        }
+        interp.enableTracing();
+        interp.enableProfiling();
+
+        // No probes are emitted, the profile is used if the untraced variant already finished collecting it.
+        bool profiled = PyJit_Settings().pgc && state->j_pgc_status == Optimized;
+        res = interp.compile(frame->f_builtins, frame->f_globals,
+                             profiled ? state->j_profile : nullptr,
+                             profiled ? CompiledWithProbes : Uncompiled);
+    }
+    Py_XDECREF(res.instructionGraph);
+    auto interpreterState = PyJit_InterpreterState();
+    if (res.compiledCode == nullptr || res.result != Success) {
+        state->j_hookedFailed = true;
+        interpreterState->failed++;
+        return _PyEval_EvalFrameDefault(tstate, frame, 0);
+    }
+    interpreterState->compiled++;
+    interpreterState->ilBytes += res.compiledCode->get_il_len();
+    interpreterState->nativeBytes += res.compiledCode->get_native_size();
+    state->j_hookedAddr = (Py_EvalFunc) res.compiledCode->get_code_addr();
+    state->j_tracingHooks = true;
+    state->j_profilingHooks = true;
+    return PyJit_ExecuteJittedFrame((void*) state->j_hookedAddr, frame, tstate, state);
+}
+
+// Set by PyJit_ConsumeGenerator for the generator expression frame it's about to start, taken by PyJit_EvalFrame
+static thread_local PyFrameObject* t_consumerFrame = nullptr;
+static thread_local PyjionConsumer* t_consumer = nullptr;
+
+void PyJit_RequestConsumer(PyFrameObject* frame, PyjionConsumer* consumer) {
+    t_consumerFrame = frame;
+    t_consumer = consumer;
+}
+
+void PyJit_WithdrawConsumer(PyjionConsumer* consumer) {
+    // A generator started as usual can make requests of its own, which replace and clear this one
+    if (t_consumer != consumer)
+        return;
+    t_consumerFrame = nullptr;
+    t_consumer = nullptr;
+}
+
+// Compiles the variant of a generator expression that passes each value to its consumer instead of yielding it.
+// It never suspends, so it runs the whole loop in one call and keeps the iterator specializations of regular functions.
+static bool PyJit_CompileConsumerFrame(PyjionJittedCode* state, PyFrameObject* frame) {
+    PyjionPolicyScope policy(state);
+    PythonCompiler jitter((PyCodeObject*) state->j_code);
+    AbstractInterpreter interp((PyCodeObject*) state->j_code, &jitter);
+    int argCount = frame->f_code->co_argcount + frame->f_code->co_kwonlyargcount;
+
+    for (int i = 0; i < argCount; i++) {
+        interp.setLocalType(i, frame->f_localsplus[i]);
+    }
+    interp.disableTracing();
+    interp.disableProfiling();
+    interp.enableConsumer();
+
+    bool profiled = PyJit_Settings().pgc && state->j_pgc_status == Optimized;
+    auto res = interp.compile(frame->f_builtins, frame->f_globals,
+                              profiled ? state->j_profile : nullptr,
+                              profiled ? CompiledWithProbes : Uncompiled);
+    Py_XDECREF(res.instructionGraph);
+    auto interpreterState = PyJit_InterpreterState();
+    if (res.compiledCode == nullptr || res.result != Success) {
+        state->j_consumerFailed = true;
+        interpreterState->failed++;
+        return false;
+    }
+    interpreterState->compiled++;
+    interpreterState->ilBytes += res.compiledCode->get_il_len();
+    interpreterState->nativeBytes += res.compiledCode->get_native_size();
+    state->j_consumerAddr = (Py_EvalFunc) res.compiledCode->get_code_addr();
+    return true;
+}
+
+// Compiles the variant of a function called by PyJit_CallDirect, which takes its int and float arguments and returns
+// unboxed ints and floats through the PyjionDirectCall it gets in place of its first argument.
+static bool PyJit_CompileDirectFrame(PyjionJittedCode* state, PyFrameObject* frame) {
+    PyjionPolicyScope policy(state);
+    PythonCompiler jitter((PyCodeObject*) state->j_code);
+    AbstractInterpreter interp((PyCodeObject*) state->j_code, &jitter);
+    int argCount = frame->f_code->co_argcount + frame->f_code->co_kwonlyargcount;
+
+    for (int i = 0; i < argCount; i++) {
+        interp.setLocalType(i, frame->f_localsplus[i]);
+    }
+    interp.disableTracing();
+    interp.disableProfiling();
+    interp.enableDirectVariant();
+
+    bool profiled = PyJit_Settings().pgc && state->j_pgc_status == Optimized;
+    auto res = interp.compile(frame->f_builtins, frame->f_globals,
+                              profiled ? state->j_profile : nullptr,
+                              profiled ? CompiledWithProbes : Uncompiled);
+    Py_XDECREF(res.instructionGraph);
+    auto interpreterState = PyJit_InterpreterState();
+    if (res.compiledCode == nullptr || res.result != Success) {
+        state->j_directFailed = true;
+        interpreterState->failed++;
+        return false;
+    }
+    interpreterState->compiled++;
+    interpreterState->ilBytes += res.compiledCode->get_il_len();
+    interpreterState->nativeBytes += res.compiledCode->get_native_size();
+    for (py_oparg i = 0; i < DIRECT_CALL_MAX_ARGS; i++) {
+        state->j_directArgKinds[i] = interp.getDirectArgKind(i);
+    }
+    state->j_directAddr = (Py_EvalFunc) res.compiledCode->get_code_addr();
+    return true;
+}
+
+PyObject* PyJit_ExecuteAndCompileFrame(PyjionJittedCode* state, PyFrameObject* frame, PyThreadState* tstate, PyjionCodeProfile* profile) {
+    if (PyJit_HooksActive(tstate))
+        return PyJit_ExecuteAndCompileHookedFrame(state, frame, tstate);
+
+    // Compile and run the now compiled code...
+    AbstactInterpreterCompileResult res;
+    {
+        // The policy only applies while compiling, not to the callees compiled while the frame runs
+        PyjionPolicyScope policy(state);
+        PythonCompiler jitter((PyCodeObject*) state->j_code);
+        AbstractInterpreter interp((PyCodeObject*) state->j_code, &jitter);
+        int argCount = frame->f_code->co_argcount + frame->f_code->co_kwonlyargcount;
+
+        // provide the interpreter information about the specialized types
+        for (int i = 0; i < argCount; i++) {
+            interp.setLocalType(i, frame->f_localsplus[i]);
+        }
+
+        // Tracing and profiling hooks are only compiled into the variant used while they are active
+        interp.disableTracing();
+        interp.disableProfiling();
+
+        res = interp.compile(frame->f_builtins, frame->f_globals, profile, state->j_pgc_status);
+    }
+    if (!PyJit_UpdateJittedCode(state, res, profile)) {
+        return _PyEval_EvalFrameDefault(tstate, frame, 0);
+    }
 
 #ifdef DUMP_SEQUENCE_POINTS
     printf("Method disassembly for %s\n", PyUnicode_AsUTF8(frame->f_code->co_name));
@@ -276,16 +641,15 @@ PyObject* PyJit_ExecuteAndCompileFrame(PyjionJittedCode* state, PyFrameObject* f
 }
 
 PyjionJittedCode* PyJit_EnsureExtra(PyObject* codeObject) {
-    auto index = (ssize_t) PyThread_tss_get(g_extraSlot);
-    if (index == 0) {
+    // co_extra indices are allocated by each interpreter
+    auto interpreterState = PyJit_InterpreterState();
+    auto index = interpreterState->codeExtraIndex;
+    if (index == -1) {
         index = _PyEval_RequestCodeExtraIndex(PyjionJitFree);
         if (index == -1) {
             return nullptr;
         }
-
-        PyThread_tss_set(g_extraSlot, (void*) ((index << 1) | 0x01));
-    } else {
-        index = index >> 1;
+        interpreterState->codeExtraIndex = index;
     }
 
     PyjionJittedCode* jitted = nullptr;
@@ -308,14 +672,65 @@ PyjionJittedCode* PyJit_EnsureExtra(PyObject* codeObject) {
     return jitted;
 }
 
+// Returns the jitted code state of a code object without creating it.
+static PyjionJittedCode* PyJit_FindExtra(PyObject* codeObject) {
+    auto index = PyJit_InterpreterState()->codeExtraIndex;
+    if (index == -1)
+        return nullptr;
+
+    PyjionJittedCode* jitted = nullptr;
+    if (_PyCode_GetExtra(codeObject, index, (void**) &jitted)) {
+        PyErr_Clear();
+        return nullptr;
+    }
+    return jitted;
+}
+
+// Once frozen, nothing is compiled and the jitted code state is only read, no run counts are kept and none is
+// allocated for new code objects, so the pages it lives on stay shared with the process that called pyjion.freeze().
+static PyObject* PyJit_EvalFrozenFrame(PyThreadState* ts, PyFrameObject* f, int throwflag) {
+    auto jitted = PyJit_FindExtra((PyObject*) f->f_code);
+    if (jitted != nullptr && !throwflag) {
+        if (PyJit_HooksActive(ts)) {
+            if (jitted->j_hookedAddr != nullptr)
+                return PyJit_ExecuteJittedFrame((void*) jitted->j_hookedAddr, f, ts, jitted);
+        } else if (jitted->j_addr != nullptr && !jitted->j_failed && (!PyJit_PgcEnabled(jitted) || jitted->j_pgc_status == Optimized)) {
+            return PyJit_ExecuteJittedFrame((void*) jitted->j_addr, f, ts, jitted);
+        }
+    }
+    return _PyEval_EvalFrameDefault(ts, f, throwflag);
+}
+
 // This is our replacement evaluation function.  We lookup our corresponding jitted code
 // and dispatch to it if it's already compiled.  If it hasn't yet been compiled we'll
 // eventually compile it and invoke it.  If it's not time to compile it yet then we'll
 // invoke the default evaluation function.
 PyObject* PyJit_EvalFrame(PyThreadState* ts, PyFrameObject* f, int throwflag) {
+    if (PyJit_Settings().frozen)
+        return PyJit_EvalFrozenFrame(ts, f, throwflag);
     auto jitted = PyJit_EnsureExtra((PyObject*) f->f_code);
     if (jitted != nullptr && !throwflag) {
-        if (jitted->j_addr != nullptr && !jitted->j_failed && (!g_pyjionSettings.pgc || jitted->j_pgc_status == Optimized)) {
+        if (!jitted->j_policyResolved)
+            PyJit_ResolvePolicy(jitted, f->f_globals);
+        if (!jitted->j_policy.enabled)
+            return _PyEval_EvalFrameDefault(ts, f, throwflag);
+        if (t_consumerFrame == f && !PyJit_HooksActive(ts) &&
+            (jitted->j_consumerAddr != nullptr || (!jitted->j_consumerFailed && PyJit_CompileConsumerFrame(jitted, f)))) {
+            // A generator expression passed to sum(), any() etc. by jitted code, the caller is hot so compile it right away
+            auto consumer = t_consumer;
+            consumer->taken = true;
+            PyJit_WithdrawConsumer(consumer);
+            return PyJit_ExecuteJittedFrame((void*) jitted->j_consumerAddr, f, ts, jitted, consumer);
+        }
+        if (PyJit_HooksActive(ts)) {
+            // A tracer or profiler is attached, use the variant with the hooks. It is compiled on the first traced call
+            // of code that is already compiled, or once it gets hot while traced.
+            if (jitted->j_hookedAddr != nullptr) {
+                return PyJit_ExecuteJittedFrame((void*) jitted->j_hookedAddr, f, ts, jitted);
+            } else if (!jitted->j_hookedFailed && (jitted->j_addr != nullptr || jitted->j_run_count++ >= jitted->j_specialization_threshold)) {
+                return PyJit_ExecuteAndCompileFrame(jitted, f, ts, jitted->j_profile);
+            }
+        } else if (jitted->j_addr != nullptr && !jitted->j_failed && (!PyJit_PgcEnabled(jitted) || jitted->j_pgc_status == Optimized)) {
             jitted->j_run_count++;
             return PyJit_ExecuteJittedFrame((void*) jitted->j_addr, f, ts, jitted);
         } else if (!jitted->j_failed && jitted->j_run_count++ >= jitted->j_specialization_threshold) {
@@ -327,6 +742,155 @@ PyObject* PyJit_EvalFrame(PyThreadState* ts, PyFrameObject* f, int throwflag) {
     return _PyEval_EvalFrameDefault(ts, f, throwflag);
 }
 
+// Unboxes the result of a call that wasn't made through a direct variant, or was returned boxed by one
+static int32_t PyJit_UnboxDirectResult(PyObject* value, AbstractValueKind kind, void* result) {
+    if (value == nullptr)
+        return -1;
+    int failure = 0;
+    if (kind == AVK_Float) {
+        if (PyFloat_CheckExact(value))
+            *(double*) result = PyFloat_AS_DOUBLE(value);
+        else {
+            PyJit_PgcGuardException(value, "float");
+            failure = 1;
+        }
+    } else {
+        *(int64_t*) result = PyJit_LongAsLongLong(value, &failure);
+    }
+    Py_DECREF(value);
+    return failure ? -1 : 0;
+}
+
+// Boxes an argument a direct call passed unboxed
+static PyObject* PyJit_BoxDirectArg(PyjionDirectValue value, AbstractValueKind kind) {
+    return kind == AVK_Float ? PyFloat_FromDouble(value.asFloat) : PyLong_FromLongLong(value.asInt);
+}
+
+// Unboxes an argument for a direct variant that takes it as kind, returns false if it isn't exactly of that kind
+static bool PyJit_UnboxDirectArg(PyObject* arg, AbstractValueKind kind, PyjionDirectValue* value) {
+    if (kind == AVK_Float) {
+        if (!PyFloat_CheckExact(arg))
+            return false;
+        value->asFloat = PyFloat_AS_DOUBLE(arg);
+        return true;
+    }
+    if (!PyLong_CheckExact(arg))
+        return false;
+    int overflow = 0;
+    value->asInt = PyLong_AsLongLongAndOverflow(arg, &overflow);
+    return overflow == 0;
+}
+
+int32_t PyJit_CallDirect(PyObject* function, void* arg0, void* arg1, void* arg2, int32_t nargs, int32_t argKinds, int32_t kind, void* result) {
+    void* argValues[DIRECT_CALL_MAX_ARGS] = {arg0, arg1, arg2};
+    PyObject* args[DIRECT_CALL_MAX_ARGS] = {};
+    // The kind of each argument still unboxed in call.args, AVK_Any once it's an object
+    AbstractValueKind kinds[DIRECT_CALL_MAX_ARGS] = {AVK_Any, AVK_Any, AVK_Any};
+    PyjionDirectCall call{AVK_Any};
+    for (int32_t i = 0; i < nargs; i++) {
+        kinds[i] = directArgKind(argKinds, i);
+        if (kinds[i] == AVK_Any)
+            args[i] = (PyObject*) argValues[i];
+        else
+            call.args[i] = *(PyjionDirectValue*) argValues[i];
+    }
+    auto resultKind = (AbstractValueKind) kind;
+    auto tstate = PyThreadState_GET();
+    PyjionJittedCode* jitted = nullptr;
+    // Only functions that PyJit_EvalFrame would run compiled are called directly, anything else is called as usual
+    if (supportsDirectCall(function, nargs) && !PyJit_HooksActive(tstate)) {
+        jitted = PyJit_FindExtra(PyFunction_GET_CODE(function));
+        if (jitted != nullptr && (!jitted->j_policy.enabled || jitted->j_addr == nullptr || jitted->j_failed || jitted->j_directFailed ||
+                                  (PyJit_PgcEnabled(jitted) && jitted->j_pgc_status != Optimized)))
+            jitted = nullptr;
+    }
+    bool direct = jitted != nullptr && jitted->j_directAddr != nullptr;
+
+    // Box the arguments the direct variant doesn't take unboxed as the same kind
+    for (int32_t i = 0; i < nargs; i++) {
+        if (kinds[i] == AVK_Any || (direct && jitted->j_directArgKinds[i] == kinds[i]))
+            continue;
+        args[i] = PyJit_BoxDirectArg(call.args[i], kinds[i]);
+        kinds[i] = AVK_Any;
+        if (args[i] == nullptr) {
+            Py_DECREF(function);
+            for (int32_t j = 0; j < nargs; j++) {
+                if (kinds[j] == AVK_Any)
+                    Py_XDECREF(args[j]);
+            }
+            return -1;
+        }
+    }
+    if (jitted == nullptr) {
+        auto value = PyObject_Vectorcall(function, args, nargs, nullptr);
+        Py_DECREF(function);
+        for (int32_t i = 0; i < nargs; i++)
+            Py_DECREF(args[i]);
+        return PyJit_UnboxDirectResult(value, resultKind, result);
+    }
+
+    auto frame = PyFrame_New(tstate, (PyCodeObject*) PyFunction_GET_CODE(function), PyFunction_GET_GLOBALS(function), nullptr);
+    Py_DECREF(function);
+    if (frame == nullptr) {
+        for (int32_t i = 0; i < nargs; i++)
+            Py_XDECREF(args[i]);
+        return -1;
+    }
+    // The frame takes the references to the arguments, those still unboxed are left unbound
+    for (int32_t i = 0; i < nargs; i++)
+        frame->f_localsplus[i] = args[i];
+
+    if (!PyJit_Settings().frozen)
+        jitted->j_run_count++;
+    if (!direct && !PyJit_Settings().frozen && PyJit_CompileDirectFrame(jitted, frame))
+        direct = true;
+    // The direct variant can only be run if the arguments it takes unboxed are exactly of their kind
+    for (int32_t i = 0; direct && i < nargs; i++) {
+        if (jitted->j_directArgKinds[i] != AVK_Any && kinds[i] == AVK_Any)
+            direct = PyJit_UnboxDirectArg(frame->f_localsplus[i], jitted->j_directArgKinds[i], &call.args[i]);
+    }
+    for (int32_t i = 0; i < nargs; i++) {
+        if (direct && jitted->j_directArgKinds[i] != AVK_Any) {
+            Py_CLEAR(frame->f_localsplus[i]);
+        } else if (frame->f_localsplus[i] == nullptr) {
+            frame->f_localsplus[i] = PyJit_BoxDirectArg(call.args[i], kinds[i]);
+            if (frame->f_localsplus[i] == nullptr) {
+                Py_DECREF(frame);
+                return -1;
+            }
+        }
+    }
+
+    PyObject* value;
+    if (direct)
+        value = PyJit_ExecuteJittedFrame((void*) jitted->j_directAddr, frame, tstate, jitted, &call);
+    else
+        value = PyJit_ExecuteJittedFrame((void*) jitted->j_addr, frame, tstate, jitted);
+    Py_DECREF(frame);
+
+    if (value != (PyObject*) SIG_UNBOXED_RETURN)
+        return PyJit_UnboxDirectResult(value, resultKind, result);
+    if (call.returnKind == resultKind) {
+        if (resultKind == AVK_Float)
+            *(double*) result = call.returnValue.asFloat;
+        else
+            *(int64_t*) result = call.returnValue.asInt;
+        return 0;
+    }
+    // The callee returned the other kind, box it so the guard fails as it would have for a boxed result
+    value = PyJit_BoxDirectArg(call.returnValue, call.returnKind);
+    return PyJit_UnboxDirectResult(value, resultKind, result);
+}
+
+AbstractValueKind PyJit_DirectArgKind(PyObject* function, size_t arg) {
+    if (!PyFunction_Check(function) || arg >= DIRECT_CALL_MAX_ARGS)
+        return AVK_Any;
+    auto jitted = PyJit_FindExtra(PyFunction_GET_CODE(function));
+    if (jitted == nullptr || jitted->j_directAddr == nullptr)
+        return AVK_Any;
+    return jitted->j_directArgKinds[arg];
+}
+
 void PyjionJitFree(void* obj) {
     if (obj == nullptr)
         return;
@@ -339,7 +903,7 @@ void PyjionJitFree(void* obj) {
 }
 
 static PyInterpreterState* inter() {
-    return PyInterpreterState_Main();
+    return PyInterpreterState_Get();
 }
 
 static PyObject* pyjion_enable(PyObject* self, PyObject* args) {
@@ -360,6 +924,25 @@ static PyObject* pyjion_disable(PyObject* self, PyObject* args) {
     Py_RETURN_FALSE;
 }
 
+static PyObject* pyjion_freeze(PyObject* self, PyObject* args) {
+    bool wasFrozen = PyJit_Settings().frozen;
+    PyJit_Settings().frozen = true;
+    g_codeArena.freeze();
+    if (wasFrozen)
+        Py_RETURN_FALSE;
+    Py_RETURN_TRUE;
+}
+
+static PyObject* pyjion_stats(PyObject* self, PyObject* args) {
+    auto state = PyJit_InterpreterState();
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n}",
+                         "compiled", (Py_ssize_t) state->compiled,
+                         "failed", (Py_ssize_t) state->failed,
+                         "il_bytes", (Py_ssize_t) state->ilBytes,
+                         "native_bytes", (Py_ssize_t) state->nativeBytes,
+                         "code_heap_bytes", (Py_ssize_t) g_codeArena.committed());
+}
+
 static PyObject* pyjion_info(PyObject* self, PyObject* func) {
     PyObject* code;
     if (PyFunction_Check(func)) {
@@ -380,6 +963,8 @@ static PyObject* pyjion_info(PyObject* self, PyObject* func) {
     PyDict_SetItemString(res, "failed", jitted->j_failed ? Py_True : Py_False);
     PyDict_SetItemString(res, "tracing", jitted->j_tracingHooks ? Py_True : Py_False);
     PyDict_SetItemString(res, "profiling", jitted->j_profilingHooks ? Py_True : Py_False);
+    PyDict_SetItemString(res, "consumer", jitted->j_consumerAddr != nullptr ? Py_True : Py_False);
+    PyDict_SetItemString(res, "direct", jitted->j_directAddr != nullptr ? Py_True : Py_False);
     PyDict_SetItemString(res, "compile_result", PyLong_FromLong(jitted->j_compile_result));
     PyDict_SetItemString(res, "compiled", jitted->j_addr != nullptr ? Py_True : Py_False);
     PyDict_SetItemString(res, "optimizations", PyLong_FromLong(jitted->j_optimizations));
@@ -543,6 +1128,216 @@ static PyObject* pyjion_symbols(PyObject* self, PyObject* func) {
     return table;
 }
 
+// Resolves the code, builtins, globals and declared argument types of a pyjion.compile() target.
+static PyjionJittedCode* getCompileTarget(PyObject* func, PyObject* argTypes, PyObject* globals, PyjionPrecompileRequest& request) {
+    PyObject* code;
+    if (PyFunction_Check(func)) {
+        code = ((PyFunctionObject*) func)->func_code;
+        request.builtins = ((PyFunctionObject*) func)->func_builtins;
+        if (globals == Py_None)
+            globals = ((PyFunctionObject*) func)->func_globals;
+    } else if (PyCode_Check(func)) {
+        code = func;
+        request.builtins = PyEval_GetBuiltins();
+        if (globals == Py_None) {
+            PyErr_SetString(PyExc_TypeError, "Expected globals when compiling a code object");
+            return nullptr;
+        }
+    } else {
+        PyErr_SetString(PyExc_TypeError, "Expected function or code");
+        return nullptr;
+    }
+    if (!PyDict_Check(globals)) {
+        PyErr_SetString(PyExc_TypeError, "Expected dict for globals");
+        return nullptr;
+    }
+    request.globals = globals;
+
+    if (argTypes != Py_None) {
+        auto seq = PyObject_ptr(PySequence_Fast(argTypes, "Expected sequence of types for arg_types"));
+        if (seq.get() == nullptr)
+            return nullptr;
+        for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq.get()); i++) {
+            auto item = PySequence_Fast_GET_ITEM(seq.get(), i);
+            if (item == Py_None) {
+                request.argTypes.push_back(nullptr);
+            } else if (PyType_Check(item)) {
+                request.argTypes.push_back((PyTypeObject*) item);
+            } else {
+                PyErr_SetString(PyExc_TypeError, "Expected type or None in arg_types");
+                return nullptr;
+            }
+        }
+    }
+
+    request.state = PyJit_EnsureExtra(code);
+    if (request.state == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "Cannot allocate JIT state for code object");
+        return nullptr;
+    }
+    if (!request.state->j_policyResolved)
+        PyJit_ResolvePolicy(request.state, globals);
+    return request.state;
+}
+
+static PyObject* pyjion_compile(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* kwlist[] = {"f", "arg_types", "globals", nullptr};
+    PyObject *func, *argTypes = Py_None, *globals = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OO:compile", const_cast<char**>(kwlist), &func, &argTypes, &globals)) {
+        return nullptr;
+    }
+    // Frozen code pages are shared with forked processes, nothing more is compiled into them
+    if (PyJit_Settings().frozen)
+        Py_RETURN_FALSE;
+
+    PyjionPrecompileRequest request;
+    if (getCompileTarget(func, argTypes, globals, request) == nullptr)
+        return nullptr;
+    if (!request.state->j_policy.enabled)
+        Py_RETURN_FALSE;
+    try {
+        if (PyJit_PrecompileCode(request.state, request.builtins, request.globals, request.argTypes)) {
+            Py_RETURN_TRUE;
+        }
+    } catch (const std::exception& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    Py_RETURN_FALSE;
+}
+
+static PyObject* pyjion_compile_batch(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* kwlist[] = {"items", "workers", nullptr};
+    PyObject* items;
+    Py_ssize_t workers = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|n:compile_batch", const_cast<char**>(kwlist), &items, &workers)) {
+        return nullptr;
+    }
+    if (workers <= 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+
+    auto seq = PyObject_ptr(PySequence_Fast(items, "Expected sequence of (f, arg_types, globals) tuples"));
+    if (seq.get() == nullptr)
+        return nullptr;
+    vector<PyjionPrecompileRequest> requests(PySequence_Fast_GET_SIZE(seq.get()));
+    vector<bool> compiled(requests.size(), false);
+    if (PyJit_Settings().frozen)
+        requests.clear();// Nothing is compiled into frozen code pages, see compile()
+    for (size_t i = 0; i < requests.size(); i++) {
+        PyObject *func, *argTypes = Py_None, *globals = Py_None;
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(seq.get(), i), "O|OO:compile_batch", &func, &argTypes, &globals))
+            return nullptr;
+        if (getCompileTarget(func, argTypes, globals, requests[i]) == nullptr)
+            return nullptr;
+    }
+
+    try {
+        if (!requests.empty())
+            compiled = PyJit_PrecompileBatch(requests, workers);
+    } catch (const std::exception& e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return nullptr;
+    }
+    auto results = PyList_New(compiled.size());
+    if (results == nullptr)
+        return nullptr;
+    for (size_t i = 0; i < compiled.size(); i++) {
+        PyList_SET_ITEM(results, i, PyBool_FromLong(compiled[i]));
+    }
+    return results;
+}
+
+// Reads the policy arguments of set_policy and add_module_policy, None leaves the interpreter's setting in place.
+static bool getPolicy(int enabled, PyObject* level, PyObject* pgc, PyObject* threshold, PyjionPolicy& policy) {
+    policy.enabled = enabled != 0;
+    if (level != Py_None) {
+        if (!PyLong_Check(level)) {
+            PyErr_SetString(PyExc_TypeError, "Expected int for optimization level");
+            return false;
+        }
+        auto value = PyLong_AsLong(level);
+        if (value < 0 || value > 2) {
+            PyErr_SetString(PyExc_ValueError, "Level not in range of 0-2");
+            return false;
+        }
+        policy.level = (int8_t) value;
+    }
+    if (pgc != Py_None) {
+        if (!PyBool_Check(pgc)) {
+            PyErr_SetString(PyExc_TypeError, "Expected bool for pgc flag");
+            return false;
+        }
+        policy.pgc = pgc == Py_True ? 1 : 0;
+    }
+    if (threshold != Py_None) {
+        if (!PyLong_Check(threshold)) {
+            PyErr_SetString(PyExc_TypeError, "Expected int for threshold level");
+            return false;
+        }
+        auto value = PyLong_AsLong(threshold);
+        if (value < 0 || value > MAX_UINT8_T) {
+            PyErr_SetString(PyExc_ValueError, "Threshold cannot be negative or exceed 255");
+            return false;
+        }
+        policy.threshold = (int16_t) value;
+    }
+    return true;
+}
+
+static PyObject* pyjion_set_policy(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* kwlist[] = {"f", "enabled", "level", "pgc", "threshold", nullptr};
+    PyObject *func, *level = Py_None, *pgc = Py_None, *threshold = Py_None;
+    int enabled = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|pOOO:set_policy", const_cast<char**>(kwlist), &func, &enabled, &level, &pgc, &threshold)) {
+        return nullptr;
+    }
+    PyObject* code;
+    if (PyFunction_Check(func)) {
+        code = ((PyFunctionObject*) func)->func_code;
+    } else if (PyCode_Check(func)) {
+        code = func;
+    } else {
+        PyErr_SetString(PyExc_TypeError, "Expected function or code");
+        return nullptr;
+    }
+    PyjionPolicy policy;
+    if (!getPolicy(enabled, level, pgc, threshold, policy))
+        return nullptr;
+
+    PyjionJittedCode* jitted = PyJit_EnsureExtra(code);
+    if (jitted == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "Cannot allocate JIT state for code object");
+        return nullptr;
+    }
+    // A policy on the function takes precedence over the module policies
+    jitted->j_policy = policy;
+    jitted->j_policyResolved = true;
+    if (policy.threshold != -1)
+        jitted->j_specialization_threshold = policy.threshold;
+    Py_RETURN_NONE;
+}
+
+static PyObject* pyjion_add_module_policy(PyObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* kwlist[] = {"pattern", "enabled", "level", "pgc", "threshold", nullptr};
+    const char* pattern;
+    PyObject *level = Py_None, *pgc = Py_None, *threshold = Py_None;
+    int enabled = 1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|pOOO:add_module_policy", const_cast<char**>(kwlist), &pattern, &enabled, &level, &pgc, &threshold)) {
+        return nullptr;
+    }
+    PyjionPolicy policy;
+    if (!getPolicy(enabled, level, pgc, threshold, policy))
+        return nullptr;
+    // Only applies to code which hasn't been called yet, the policy of the others is already resolved
+    PyJit_InterpreterState()->modulePolicies.emplace_back(pattern, policy);
+    Py_RETURN_NONE;
+}
+
+static PyObject* pyjion_clear_module_policies(PyObject* self, PyObject* args) {
+    PyJit_InterpreterState()->modulePolicies.clear();
+    Py_RETURN_NONE;
+}
+
 static PyObject* pyjion_init(PyObject* self, PyObject* args) {
     if (!PyUnicode_Check(args)) {
         PyErr_SetString(PyExc_TypeError, "Expected str for new clrjit");
@@ -571,7 +1366,7 @@ pyjion_config(PyObject* self, PyObject* args, PyObject* kwargs) {
             PyErr_SetString(PyExc_TypeError, "Expected bool for pgc flag");
             return nullptr;
         }
-        g_pyjionSettings.pgc = pgc == Py_True ? true : false;
+        PyJit_Settings().pgc = pgc == Py_True ? true : false;
     }
     level = PyDict_GetItemString(kwargs, "level");
     if (level != nullptr) {
@@ -595,7 +1390,7 @@ pyjion_config(PyObject* self, PyObject* args, PyObject* kwargs) {
             PyErr_SetString(PyExc_TypeError, "Expected bool for debug flag");
             return nullptr;
         }
-        g_pyjionSettings.debug = debug == Py_True ? true : false;
+        PyJit_Settings().debug = debug == Py_True ? true : false;
     }
     graph = PyDict_GetItemString(kwargs, "graph");
     if (graph) {
@@ -604,7 +1399,7 @@ pyjion_config(PyObject* self, PyObject* args, PyObject* kwargs) {
             PyErr_SetString(PyExc_TypeError, "Expected bool for graph flag");
             return nullptr;
         }
-        g_pyjionSettings.graph = graph == Py_True ? true : false;
+        PyJit_Settings().graph = graph == Py_True ? true : false;
     }
     threshold = PyDict_GetItemString(kwargs, "threshold");
     if (threshold) {
@@ -619,7 +1414,7 @@ pyjion_config(PyObject* self, PyObject* args, PyObject* kwargs) {
             PyErr_SetString(PyExc_ValueError, "Threshold cannot be negative or exceed 255");
             return nullptr;
         }
-        g_pyjionSettings.threshold = newThreshold;
+        PyJit_Settings().threshold = newThreshold;
     }
 
 return_result:
@@ -628,12 +1423,13 @@ return_result:
         return nullptr;
     }
 
-    PyDict_SetItemString(res, "clrjitpath", PyUnicode_FromWideChar(g_pyjionSettings.clrjitpath, -1));
-    PyDict_SetItemString(res, "pgc", g_pyjionSettings.pgc ? Py_True : Py_False);
-    PyDict_SetItemString(res, "graph", g_pyjionSettings.graph ? Py_True : Py_False);
-    PyDict_SetItemString(res, "debug", g_pyjionSettings.debug ? Py_True : Py_False);
-    PyDict_SetItemString(res, "level", PyLong_FromLong(g_pyjionSettings.optimizationLevel));
-    PyDict_SetItemString(res, "threshold", PyLong_FromLong(g_pyjionSettings.threshold));
+    PyDict_SetItemString(res, "clrjitpath", PyUnicode_FromWideChar(PyJit_Settings().clrjitpath, -1));
+    PyDict_SetItemString(res, "pgc", PyJit_Settings().pgc ? Py_True : Py_False);
+    PyDict_SetItemString(res, "graph", PyJit_Settings().graph ? Py_True : Py_False);
+    PyDict_SetItemString(res, "debug", PyJit_Settings().debug ? Py_True : Py_False);
+    PyDict_SetItemString(res, "level", PyLong_FromLong(PyJit_Settings().optimizationLevel));
+    PyDict_SetItemString(res, "threshold", PyLong_FromLong(PyJit_Settings().threshold));
+    PyDict_SetItemString(res, "frozen", PyJit_Settings().frozen ? Py_True : Py_False);
 
     return res;
 }
@@ -647,6 +1443,14 @@ static PyMethodDef PyjionMethods[] = {
          pyjion_disable,
          METH_NOARGS,
          "Disable the JIT.  Returns True if the JIT was disabled, False if it was already disabled."},
+        {"freeze",
+         pyjion_freeze,
+         METH_NOARGS,
+         "Stop compiling and make the compiled code read-only, so it can be shared with forked processes.  Returns True if the JIT was frozen, False if it was already frozen."},
+        {"stats",
+         pyjion_stats,
+         METH_NOARGS,
+         "Returns a dictionary of the number of functions compiled by the current interpreter and the size of their code."},
         {"info",
          pyjion_info,
          METH_O,
@@ -655,6 +1459,26 @@ static PyMethodDef PyjionMethods[] = {
          reinterpret_cast<PyCFunction>(pyjion_config),
          METH_VARARGS | METH_KEYWORDS,
          "Configure Pyjion runtime settings."},
+        {"compile",
+         reinterpret_cast<PyCFunction>(pyjion_compile),
+         METH_VARARGS | METH_KEYWORDS,
+         "Compile a function or code object now, optionally with the declared types of its arguments."},
+        {"compile_batch",
+         reinterpret_cast<PyCFunction>(pyjion_compile_batch),
+         METH_VARARGS | METH_KEYWORDS,
+         "Compile a list of (f, arg_types, globals) now, running the native compilation on a pool of threads."},
+        {"set_policy",
+         reinterpret_cast<PyCFunction>(pyjion_set_policy),
+         METH_VARARGS | METH_KEYWORDS,
+         "Set whether, and with which settings, a function or code object is compiled."},
+        {"add_module_policy",
+         reinterpret_cast<PyCFunction>(pyjion_add_module_policy),
+         METH_VARARGS | METH_KEYWORDS,
+         "Set whether, and with which settings, code in modules matching a pattern is compiled."},
+        {"clear_module_policies",
+         pyjion_clear_module_policies,
+         METH_NOARGS,
+         "Remove all the module policies."},
         {"il",
          pyjion_dump_il,
          METH_O,
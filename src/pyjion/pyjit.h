@@ -40,6 +40,7 @@
 
 #include <Python.h>
 
+#include <string>
 #include <vector>
 #include <unordered_map>
 
@@ -48,6 +49,7 @@
 #include "codemodel.h"
 #include "absvalue.h"
 #include "attrtable.h"
+#include "unboxing.h"
 
 using namespace std;
 
@@ -84,12 +86,34 @@ public:
 void capturePgcStackValue(PyjionCodeProfile* profile, PyObject* value, size_t opcodePosition, size_t stackPosition);
 class PyjionJittedCode;
 
+/* A code object to compile ahead of its first call, see PyJit_PrecompileBatch */
+struct PyjionPrecompileRequest {
+    PyjionJittedCode* state = nullptr;
+    PyObject* builtins = nullptr;
+    PyObject* globals = nullptr;
+    vector<PyTypeObject*> argTypes;
+};
+
 bool JitInit(const wchar_t* jitpath);
 PyObject* PyJit_ExecuteAndCompileFrame(PyjionJittedCode* state, PyFrameObject* frame, PyThreadState* tstate, PyjionCodeProfile* profile);
+bool PyJit_PrecompileCode(PyjionJittedCode* state, PyObject* builtins, PyObject* globals, vector<PyTypeObject*>& argTypes);
+vector<bool> PyJit_PrecompileBatch(vector<PyjionPrecompileRequest>& requests, size_t workers);
 static inline PyObject* PyJit_CheckFunctionResult(PyThreadState* tstate, PyObject* result, PyFrameObject* frame);
-static inline PyObject* PyJit_ExecuteJittedFrame(void* state, PyFrameObject* frame, PyThreadState* tstate, PyjionJittedCode*);
+struct PyjionConsumer;
+static inline PyObject* PyJit_ExecuteJittedFrame(void* state, PyFrameObject* frame, PyThreadState* tstate, PyjionJittedCode*, void* context = nullptr);
 PyObject* PyJit_EvalFrame(PyThreadState*, PyFrameObject*, int);
 PyjionJittedCode* PyJit_EnsureExtra(PyObject* codeObject);
+// Asks PyJit_EvalFrame to run frame, a generator expression about to be started, as its consumer variant
+void PyJit_RequestConsumer(PyFrameObject* frame, PyjionConsumer* consumer);
+// Clears the request if it is still the pending one, whether it was taken is recorded in the consumer
+void PyJit_WithdrawConsumer(PyjionConsumer* consumer);
+// Calls function with nargs of the (up to DIRECT_CALL_MAX_ARGS) arguments from a jitted caller that uses the result as an
+// unboxed int or float of kind, storing it in result. Returns 0, or -1 with an error set. An argument is an object if its
+// kind in argKinds (see packDirectArgKinds) is AVK_Any, otherwise the address of its unboxed value. function and the
+// object arguments are released.
+int32_t PyJit_CallDirect(PyObject* function, void* arg0, void* arg1, void* arg2, int32_t nargs, int32_t argKinds, int32_t kind, void* result);
+// The kind the compiled direct variant of function takes argument arg unboxed as, or AVK_Any if it takes an object
+AbstractValueKind PyJit_DirectArgKind(PyObject* function, size_t arg);
 
 // This type isn't exported in the Python 3.10 API, so define it here.
 typedef struct {
@@ -99,6 +123,9 @@ typedef struct {
 } PyTraceInfo;
 
 typedef PyObject* (*Py_EvalFunc)(PyjionJittedCode*, struct _frame*, PyThreadState*, PyjionCodeProfile*, PyTraceInfo*);
+// The first argument is only read by the consumer variant of a generator expression, which gets its consumer there,
+// and by the direct variant of a function, which gets its PyjionDirectCall
+typedef PyObject* (*Py_ContextEvalFunc)(void*, struct _frame*, PyThreadState*, PyjionCodeProfile*, PyTraceInfo*);
 
 
 inline OptimizationFlags operator|(OptimizationFlags a, OptimizationFlags b) {
@@ -122,15 +149,62 @@ typedef struct PyjionSettings {
 #endif
     bool exceptionHandling = false;
     const wchar_t* clrjitpath = L"";
+    bool frozen = false;// No more compilation or writes to the jitted code state, see pyjion.freeze()
 
     // Optimizations
     OptimizationFlags optimizations = OptimizationFlags();
 } PyjionSettings;
 
-extern PyjionSettings g_pyjionSettings;
-extern AttributeTable* g_attrTable;
+/* Overrides of the interpreter's settings for a function, from @pyjion.jit/@pyjion.nojit or a module policy */
+struct PyjionPolicy {
+    bool enabled = true;
+    int8_t level = -1;     // -1 uses the interpreter's settings
+    int8_t pgc = -1;       // -1 uses the interpreter's settings, otherwise 0 or 1
+    int16_t threshold = -1;// -1 uses the interpreter's settings
+};
+
+// Boxing of unboxed values without a call, see PythonCompiler::emit_box()
+#define PYJIT_SMALL_INT_MIN (-5)
+#define PYJIT_SMALL_INT_MAX 257
+#define PYJIT_FLOAT_FREELIST_SIZE 256
+
+// Float objects allocated ahead of use, the header and value are set when one is taken.
+struct PyJitFloatFreeList {
+    Py_ssize_t count;
+    PyObject* items[PYJIT_FLOAT_FREELIST_SIZE];
+};
+
+/* JIT state of a Python interpreter, the main interpreter and each subinterpreter have their own settings,
+ * attribute table, co_extra index, accounting and boxing tables. The clrjit instance, the code arena and the method
+ * table of the intrinsics (g_module) are shared between interpreters, they only change under the GIL. */
+class PyjionInterpreterState {
+public:
+    PyjionSettings settings;
+    AttributeTable attrTable;
+    Py_ssize_t codeExtraIndex = -1;
+    // Module name patterns (fnmatch style) and their policy, the first match applies
+    vector<pair<string, PyjionPolicy>> modulePolicies;
+    size_t compiled = 0;
+    size_t failed = 0;
+    size_t ilBytes = 0;
+    size_t nativeBytes = 0;
+
+    // Objects of this interpreter whose addresses are baked into its jitted code, set up by JitInit()
+    PyObject* emptyTuple = nullptr;
+    PyObject* smallInts[PYJIT_SMALL_INT_MAX - PYJIT_SMALL_INT_MIN] = {};
+    PyJitFloatFreeList floatFreeList = {};
+    // The C functions behind sum(), any(), all(), min() and max(), indexed by PyjionConsumerKind
+    vector<PyCFunction> consumerFunctions;
+};
+
+/* Returns the JIT state of the current thread's interpreter, creating it on first use. Requires the GIL. */
+PyjionInterpreterState* PyJit_InterpreterState();
+
+inline PyjionSettings& PyJit_Settings() {
+    return PyJit_InterpreterState()->settings;
+}
 
-#define OPT_ENABLED(opt) ((g_pyjionSettings.optimizations & (opt)) == (opt))
+#define OPT_ENABLED(opt) ((PyJit_Settings().optimizations & (opt)) == (opt))
 void PyjionJitFree(void* obj);
 
 int Pyjit_CheckRecursiveCall(PyThreadState* tstate, const char* where);
@@ -168,8 +242,21 @@ public:
     unsigned int j_callPointsLen;
     PyObject* j_graph;
     SymbolTable j_symbols;
+    // Variant compiled with tracing and profiling hooks, used while a tracer or profiler is attached
+    Py_EvalFunc j_hookedAddr;
+    bool j_hookedFailed;
     bool j_tracingHooks;
     bool j_profilingHooks;
+    // Variant of a generator expression that passes its values to the builtin consuming it instead of yielding them
+    Py_EvalFunc j_consumerAddr;
+    bool j_consumerFailed;
+    // Variant called by PyJit_CallDirect from jitted callers, returning unboxed ints and floats through PyjionDirectCall.
+    // It reads the arguments whose kind in j_directArgKinds isn't AVK_Any unboxed from PyjionDirectCall::args.
+    Py_EvalFunc j_directAddr;
+    bool j_directFailed;
+    AbstractValueKind j_directArgKinds[DIRECT_CALL_MAX_ARGS];
+    PyjionPolicy j_policy;
+    bool j_policyResolved;// Set once j_policy is final, either set explicitly or matched against the module policies
 
     explicit PyjionJittedCode(PyObject* code) {
         j_compile_result = 0;
@@ -178,7 +265,7 @@ public:
         j_run_count = 0;
         j_failed = false;
         j_addr = nullptr;
-        j_specialization_threshold = g_pyjionSettings.threshold;
+        j_specialization_threshold = PyJit_Settings().threshold;
         j_il = nullptr;
         j_ilLen = 0;
         j_nativeSize = 0;
@@ -189,8 +276,17 @@ public:
         j_sequencePointsLen = 0;
         j_callPoints = nullptr;
         j_callPointsLen = 0;
+        j_hookedAddr = nullptr;
+        j_hookedFailed = false;
         j_tracingHooks = false;
         j_profilingHooks = false;
+        j_consumerAddr = nullptr;
+        j_consumerFailed = false;
+        j_directAddr = nullptr;
+        j_directFailed = false;
+        for (auto& kind : j_directArgKinds)
+            kind = AVK_Any;
+        j_policyResolved = false;
         Py_INCREF(code);
     }
 
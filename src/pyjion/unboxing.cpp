@@ -61,6 +61,14 @@ bool supportsUnboxing(py_opcode opcode) {
         case UNARY_POSITIVE:
         case UNARY_NEGATIVE:
         case UNARY_INVERT:
+        case ROT_TWO:
+        case ROT_THREE:
+        case ROT_FOUR:
+        case BUILD_TUPLE:
+        case UNPACK_SEQUENCE:
+        case CALL_METHOD:
+        case CALL_FUNCTION:
+        case RETURN_VALUE:
             return true;
         default:
             return false;
@@ -102,6 +110,15 @@ bool supportsUnboxing(py_opcode opcode, vector<AbstractValueKind> edgesIn) {
             if (edgesIn.size() == 2 && edgesIn[0] == AVK_Integer && edgesIn[1] == AVK_Bytearray)
                 return true;
             return false;
+        case ROT_TWO:
+        case ROT_THREE:
+        case ROT_FOUR:
+        case BUILD_TUPLE:// Only when immediately unpacked, see InstructionGraph::isUnpackedTuple
+            for (auto& t : edgesIn) {
+                if (t != AVK_Integer && t != AVK_Float && t != AVK_Bool)
+                    return false;
+            }
+            return true;
         default:
             return true;
     }
@@ -120,3 +137,172 @@ bool supportsEscaping(AbstractValueKind kind) {// TODO: Allow filter for the spe
             return false;
     }
 }
+
+static const NativeMathFunction nativeMathFunctions[] = {
+        {"sqrt", static_cast<double (*)(double)>(sqrt), false, false},
+        {"exp", static_cast<double (*)(double)>(exp), true, false},
+        {"log", static_cast<double (*)(double)>(log), false, false},
+        {"log2", static_cast<double (*)(double)>(log2), false, false},
+        {"log10", static_cast<double (*)(double)>(log10), false, false},
+        {"sin", static_cast<double (*)(double)>(sin), false, false},
+        {"cos", static_cast<double (*)(double)>(cos), false, false},
+        {"tan", static_cast<double (*)(double)>(tan), false, false},
+        {"asin", static_cast<double (*)(double)>(asin), false, false},
+        {"acos", static_cast<double (*)(double)>(acos), false, false},
+        {"atan", static_cast<double (*)(double)>(atan), false, false},
+        {"sinh", static_cast<double (*)(double)>(sinh), true, false},
+        {"cosh", static_cast<double (*)(double)>(cosh), true, false},
+        {"tanh", static_cast<double (*)(double)>(tanh), false, false},
+        {"fabs", static_cast<double (*)(double)>(fabs), false, false},
+        {"floor", static_cast<double (*)(double)>(floor), false, true},
+        {"ceil", static_cast<double (*)(double)>(ceil), false, true},
+};
+
+const NativeMathFunction* nativeMathFunction(PyObject* module, const char* name, AbstractValueKind argKind, PyMethodDef** def) {
+    if (module == nullptr || !PyModule_CheckExact(module))
+        return nullptr;
+    auto moduleName = PyModule_GetNameObject(module);
+    if (moduleName == nullptr) {
+        PyErr_Clear();
+        return nullptr;
+    }
+    bool isMath = PyUnicode_CompareWithASCIIString(moduleName, "math") == 0;
+    Py_DECREF(moduleName);
+    if (!isMath)
+        return nullptr;
+
+    for (const auto& function : nativeMathFunctions) {
+        if (strcmp(function.name, name) != 0)
+            continue;
+        // floor() and ceil() of an int return it as it is, which a double can't hold beyond 2**53
+        if (function.returnsInt ? argKind != AVK_Float : (argKind != AVK_Float && argKind != AVK_Integer && argKind != AVK_Bool))
+            return nullptr;
+        auto attr = PyObject_GetAttrString(module, name);
+        if (attr == nullptr) {
+            PyErr_Clear();
+            return nullptr;
+        }
+        // Must still be the builtin, not something patched onto the module
+        bool isBuiltin = PyCFunction_CheckExact(attr) && PyCFunction_GET_SELF(attr) == module &&
+                         strcmp(((PyCFunctionObject*) attr)->m_ml->ml_name, name) == 0;
+        if (isBuiltin && def != nullptr)
+            *def = ((PyCFunctionObject*) attr)->m_ml;
+        Py_DECREF(attr);
+        return isBuiltin ? &function : nullptr;
+    }
+    return nullptr;
+}
+
+static PyTypeObject* inlineIsInstanceTypes[] = {&PyLong_Type, &PyBool_Type, &PyFloat_Type, &PyUnicode_Type, &PyBytes_Type,
+                                                &PyList_Type, &PyTuple_Type, &PyDict_Type, &PySet_Type};
+
+// The builtin could have been replaced in the builtins module before compiling
+static bool isBuiltinFunction(BuiltinSource* source, const char* name) {
+    auto value = source->getValue();
+    return strcmp(source->getName(), name) == 0 && value != nullptr && PyCFunction_CheckExact(value) &&
+           strcmp(((PyCFunctionObject*) value)->m_ml->ml_name, name) == 0;
+}
+
+static bool isBuiltinType(BuiltinSource* source, const char* name, PyTypeObject* type) {
+    return strcmp(source->getName(), name) == 0 && source->getValue() == (PyObject*) type;
+}
+
+InlineBuiltin inlineBuiltin(AbstractSource* function, const vector<AbstractValueKind>& args, AbstractSource* type) {
+    if (function == nullptr || !function->isBuiltin())
+        return NoInlineBuiltin;
+    auto builtin = dynamic_cast<BuiltinSource*>(function);
+    if (args.size() == 1 && isBuiltinFunction(builtin, "len")) {
+        switch (args[0]) {
+            case AVK_List:
+            case AVK_Tuple:
+            case AVK_String:
+            case AVK_Bytes:
+            case AVK_Dict:
+            case AVK_Set:
+                return InlineLen;
+            default:
+                return NoInlineBuiltin;
+        }
+    }
+    if (args.size() == 1 && (args[0] == AVK_Integer || args[0] == AVK_Float) && isBuiltinFunction(builtin, "abs"))
+        return InlineAbs;
+    if (args.size() == 1 && args[0] == AVK_Complex && isBuiltinFunction(builtin, "abs"))
+        return InlineAbsComplex;
+    if (args.size() == 2 && args[0] == args[1] && (args[0] == AVK_Integer || args[0] == AVK_Float)) {
+        if (isBuiltinFunction(builtin, "min"))
+            return InlineMin;
+        if (isBuiltinFunction(builtin, "max"))
+            return InlineMax;
+    }
+    if (args.size() == 1 && (args[0] == AVK_Integer || args[0] == AVK_Float || args[0] == AVK_Bool)) {
+        if (isBuiltinType(builtin, "int", &PyLong_Type))
+            return args[0] == AVK_Float ? InlineIntFromFloat : InlineInt;
+        if (isBuiltinType(builtin, "float", &PyFloat_Type))
+            return InlineFloat;
+        if (isBuiltinType(builtin, "bool", &PyBool_Type))
+            return InlineBool;
+        if (args[0] == AVK_Integer && isBuiltinType(builtin, "str", &PyUnicode_Type))
+            return InlineStr;
+    }
+    if (args.size() == 2 && type != nullptr && type->isBuiltin() && isBuiltinFunction(builtin, "isinstance")) {
+        auto typeObject = dynamic_cast<BuiltinSource*>(type)->getValue();
+        for (auto& inlineType : inlineIsInstanceTypes) {
+            if (typeObject == (PyObject*) inlineType)
+                return InlineIsInstance;
+        }
+    }
+    return NoInlineBuiltin;
+}
+
+AbstractValueKind inlineBuiltinKind(InlineBuiltin builtin, const vector<AbstractValueKind>& args) {
+    switch (builtin) {
+        case InlineLen:
+            return AVK_Integer;
+        case InlineIsInstance:
+        case InlineBool:
+            return AVK_Bool;
+        case InlineInt:
+        case InlineIntFromFloat:
+            return AVK_Integer;
+        case InlineFloat:
+        case InlineAbsComplex:
+            return AVK_Float;
+        case InlineStr:
+            return AVK_String;
+        case InlineAbs:
+        case InlineMin:
+        case InlineMax:
+            return args[0];
+        default:
+            return AVK_Any;
+    }
+}
+
+bool inlineBuiltinUnboxesArgs(InlineBuiltin builtin) {
+    switch (builtin) {
+        case InlineAbs:
+        case InlineMin:
+        case InlineMax:
+        case InlineInt:
+        case InlineIntFromFloat:
+        case InlineFloat:
+        case InlineBool:
+        case InlineStr:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool inlineBuiltinBoxesResult(InlineBuiltin builtin) {
+    return builtin == InlineStr || builtin == InlineIntFromFloat;
+}
+
+bool supportsDirectCall(PyObject* function, size_t nargs) {
+    if (function == nullptr || !PyFunction_Check(function) || nargs > DIRECT_CALL_MAX_ARGS)
+        return false;
+    auto code = (PyCodeObject*) PyFunction_GET_CODE(function);
+    return (code->co_flags & ~PyCF_MASK) == (CO_OPTIMIZED | CO_NEWLOCALS | CO_NOFREE) &&
+           code->co_argcount == (int) nargs && code->co_kwonlyargcount == 0 &&
+           PyFunction_GET_KW_DEFAULTS(function) == nullptr;
+}
@@ -35,4 +35,79 @@ bool supportsUnboxing(py_opcode opcode, vector<AbstractValueKind> edgesIn);
 
 bool supportsEscaping(AbstractValueKind kind);
 
+// A function of the math module that can be called on an unboxed float with no Python objects involved
+struct NativeMathFunction {
+    const char* name;
+    double (*function)(double);
+    // An infinite result for a finite argument is an OverflowError rather than a domain error
+    bool canOverflow;
+    // floor() and ceil() return an int
+    bool returnsInt;
+};
+
+// Returns the native function for module.name(arg) when module is the math module and name is still its builtin, or nullptr.
+// def is set to the method definition the builtin is checked against at runtime.
+const NativeMathFunction* nativeMathFunction(PyObject* module, const char* name, AbstractValueKind argKind, PyMethodDef** def = nullptr);
+
+// Builtins whose calls are compiled inline, see inlineBuiltin()
+enum InlineBuiltin {
+    NoInlineBuiltin,
+    InlineLen,
+    InlineAbs,
+    InlineAbsComplex,
+    InlineMin,
+    InlineMax,
+    InlineIsInstance,
+    InlineInt,
+    InlineIntFromFloat,
+    InlineFloat,
+    InlineBool,
+    InlineStr,
+};
+
+// Returns the builtin a call to function with arguments of these kinds (in call order) is compiled inline as, or NoInlineBuiltin.
+// type is the source of the second argument, isinstance() is only inlined for a builtin type.
+InlineBuiltin inlineBuiltin(AbstractSource* function, const vector<AbstractValueKind>& args, AbstractSource* type = nullptr);
+// The kind of the result of an inlined builtin, which is unboxed unless inlineBuiltinBoxesResult()
+AbstractValueKind inlineBuiltinKind(InlineBuiltin builtin, const vector<AbstractValueKind>& args);
+// abs(), min(), max() and the int(), float(), bool() and str() conversions take unboxed arguments, len(), abs() of a complex
+// and isinstance() take objects
+bool inlineBuiltinUnboxesArgs(InlineBuiltin builtin);
+// str() returns a new string object, int() of a float returns an int object as floats beyond the int64 range convert to big ints
+bool inlineBuiltinBoxesResult(InlineBuiltin builtin);
+
+// Calls to Python functions with up to this many arguments can be direct calls, see PyJit_CallDirect()
+#define DIRECT_CALL_MAX_ARGS 3
+
+union PyjionDirectValue {
+    double asFloat;
+    int64_t asInt;
+};
+
+// Passed to the direct variant of a function in place of its first argument. A return of an unboxed value stores it
+// here and returns SIG_UNBOXED_RETURN instead of boxing it.
+struct PyjionDirectCall {
+    AbstractValueKind returnKind;
+    PyjionDirectValue returnValue;
+    // The arguments the variant takes unboxed, see PyjionJittedCode::j_directArgKinds
+    PyjionDirectValue args[DIRECT_CALL_MAX_ARGS];
+};
+
+// The kinds of the arguments a direct call passes, one byte each, AVK_Any for an object
+inline int32_t packDirectArgKinds(const vector<AbstractValueKind>& kinds) {
+    int32_t packed = 0;
+    for (size_t i = 0; i < kinds.size() && i < DIRECT_CALL_MAX_ARGS; i++) {
+        packed |= (int32_t) kinds[i] << (i * 8);
+    }
+    return packed;
+}
+
+inline AbstractValueKind directArgKind(int32_t packed, size_t arg) {
+    return (AbstractValueKind) ((packed >> (arg * 8)) & 0xff);
+}
+
+// A Python function whose frame can be set up with nargs positional arguments and run without going through
+// the interpreter, the same functions CPython calls through its fast path
+bool supportsDirectCall(PyObject* function, size_t nargs);
+
 #endif//PYJION_UNBOXING_H